@@ -1,21 +1,75 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "../rapidjson/document.h"
 #include "../rapidjson/stringbuffer.h"
 #include "../rapidjson/writer.h"
 
+using JsonAllocator = rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>;
+
+//:
+//: per-thread memory pool for Json
+//: a Json made while a Scope is open allocates its values and its parse stack
+//: from the pool, the outermost Scope hands the whole pool back on exit
+//: so such a Json must not outlive the Scope it was made in
+//: outside of any Scope a Json owns its allocator like a plain Document
+//:
+class JsonArena {
+ public:
+  enum { buffer_size = 32 * 1024 };
+  enum { chunk_size = 16 * 1024 };
+  enum { parse_stack_size = 1024 };
+
+  class Scope {
+   public:
+    Scope() { ++JsonArena::Get().depth_; }
+    ~Scope() {
+      auto& arena = JsonArena::Get();
+      if (--arena.depth_ == 0) {
+        // overflow chunks go back to the heap, the fixed buffer stays
+        arena.allocator_.Clear();
+      }
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  static JsonAllocator* Current() {
+    auto& arena = Get();
+    return (arena.depth_ > 0) ? &arena.allocator_ : nullptr;
+  }
+
+ private:
+  JsonArena()
+      : depth_(0),
+        buffer_(new char[buffer_size]),
+        allocator_(buffer_.get(), buffer_size, chunk_size) {}
+
+  static JsonArena& Get() {
+    thread_local JsonArena arena;
+    return arena;
+  }
+
+  int depth_;
+  std::unique_ptr<char[]> buffer_;
+  JsonAllocator allocator_;
+};
+
 //:
 //: rapidjson::Document  Ŭ
 //:
-class Json : public rapidjson::Document {
+class Json : public rapidjson::GenericDocument<rapidjson::UTF8<>,
+                                               JsonAllocator, JsonAllocator> {
  public:
-  Json() {}
-  Json(const std::string& str) { Parse(str.c_str()); }
-  Json(const Json& json) { Parse(json.ToString().c_str()); }
-  Json(const rapidjson::Document& doc) { Parse(Json::ToString(doc).c_str()); }
-  Json(const rapidjson::Value& doc) { Parse(Json::ToString(doc).c_str()); }
+  Json()
+      : GenericDocument(rapidjson::kNullType, JsonArena::Current(),
+                        JsonArena::parse_stack_size, JsonArena::Current()) {}
+  Json(const std::string& str) : Json() { Parse(str.c_str()); }
+  Json(const char* str, const size_t length) : Json() { Parse(str, length); }
+  Json(const Json& json) : Json() { CopyFrom(json, GetAllocator()); }
+  Json(const rapidjson::Value& doc) : Json() { CopyFrom(doc, GetAllocator()); }
   ~Json() = default;
 
 #pragma region getter setter
@@ -32,7 +86,8 @@ class Json : public rapidjson::Document {
     auto itr = this->FindMember(k);
     if (itr == this->MemberEnd()) return false;
 
-    *return_value = itr->value.GetString();
+    return_value->assign(itr->value.GetString(),
+                         itr->value.GetStringLength());
     return true;
   }
   bool GetAttribute(const std::string& key, Json* return_value) const {
@@ -40,7 +95,7 @@ class Json : public rapidjson::Document {
     auto itr = this->FindMember(k);
     if (itr == this->MemberEnd()) return false;
 
-    return_value->Parse(Json::ToString(itr->value).c_str());
+    return_value->CopyFrom(itr->value, return_value->GetAllocator());
     return true;
   }
 
@@ -52,36 +107,43 @@ class Json : public rapidjson::Document {
   void SetAttribute(const std::string& key, const std::string& value) {
     auto& allocator = this->GetAllocator();
     rapidjson::Value k(key.c_str(), allocator);
-    rapidjson::Value v(value.c_str(), allocator);
+    rapidjson::Value v(value.c_str(),
+                       static_cast<rapidjson::SizeType>(value.size()),
+                       allocator);
     this->AddMember(k, v, allocator);
   }
   void SetAttribute(const std::string& key, const Json& value) {
     auto& allocator = this->GetAllocator();
     rapidjson::Value k(key.c_str(), allocator);
-    rapidjson::Document v(&allocator);
-    v.Parse(value.ToString().c_str());
+    rapidjson::Value v(value, allocator);
     this->AddMember(k, v, allocator);
   }
 #pragma endregion
 
-  std::string ToString() const {
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    this->Accept(writer);
-    return sb.GetString();
-  }
+  std::string ToString() const { return Json::ToString(*this); }
 
   static std::string ToString(const rapidjson::Value& value) {
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    value.Accept(writer);
-    return sb.GetString();
+    const auto& sb = Json::Serialize(value);
+    return std::string(sb.GetString(), sb.GetSize());
   }
 
-  static std::string ToString(const rapidjson::Document& value) {
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    value.Accept(writer);
-    return sb.GetString();
+  //:
+  //: writes value into a per-thread buffer that keeps its capacity
+  //: the result is valid until the next Serialize() on the same thread
+  //:
+  static const rapidjson::StringBuffer& Serialize(
+      const rapidjson::Value& value) {
+    thread_local Output output;
+    output.buffer.Clear();
+    output.writer.Reset(output.buffer);
+    value.Accept(output.writer);
+    return output.buffer;
   }
-};
\ No newline at end of file
+
+ private:
+  struct Output {
+    Output() : writer(buffer) {}
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer;
+  };
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+//:
+//: log-linear histogram for microsecond latencies
+//: 32 linear sub-buckets per power of two, so a percentile is within ~3%
+//:
+class LatencyHistogram {
+ public:
+  LatencyHistogram()
+      : buckets_(BUCKET_GROUPS * SUB_BUCKETS, 0), count_(0), max_(0) {}
+
+  void Record(int64_t v) {
+    v = std::max<int64_t>(v, 0);
+    ++buckets_[GetIndex(v)];
+    ++count_;
+    max_ = std::max(max_, v);
+  }
+
+  void Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    max_ = std::max(max_, other.max_);
+  }
+
+  uint64_t Count() const { return count_; }
+  int64_t Max() const { return max_; }
+
+  //: upper bound of the bucket holding the p-th percentile (0..100)
+  int64_t Percentile(const double p) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(p / 100.0 * static_cast<double>(count_) +
+                                 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        return std::min(GetUpperBound(i), max_);
+      }
+    }
+    return max_;
+  }
+
+ private:
+  enum { SUB_BUCKET_BITS = 5 };
+  enum { SUB_BUCKETS = 1 << SUB_BUCKET_BITS };
+  enum { BUCKET_GROUPS = 40 };
+
+  static size_t GetIndex(const int64_t v) {
+    if (v < SUB_BUCKETS) {
+      return static_cast<size_t>(v);
+    }
+    int msb = 0;
+    for (uint64_t x = static_cast<uint64_t>(v); x > 1; x >>= 1) {
+      ++msb;
+    }
+    const int group = msb - SUB_BUCKET_BITS + 1;
+    if (group >= BUCKET_GROUPS) {
+      return BUCKET_GROUPS * SUB_BUCKETS - 1;
+    }
+    const int64_t sub = (v >> (group - 1)) - SUB_BUCKETS;
+    return static_cast<size_t>(group * SUB_BUCKETS + sub);
+  }
+
+  static int64_t GetUpperBound(const size_t index) {
+    const int64_t group = static_cast<int64_t>(index / SUB_BUCKETS);
+    const int64_t sub = static_cast<int64_t>(index % SUB_BUCKETS);
+    if (group == 0) {
+      return sub;
+    }
+    return ((SUB_BUCKETS + sub + 1) << (group - 1)) - 1;
+  }
+
+  std::vector<uint64_t> buckets_;
+  uint64_t count_;
+  int64_t max_;
+};
@@ -0,0 +1,790 @@
+#include "load_generator.h"
+
+#include <boost/chrono/thread_clock.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+#include "message_envelope.h"
+#include "messages.h"
+#include "simple_message.h"
+
+using boost::asio::ip::tcp;
+
+namespace {
+
+const size_t MAX_PENDING_WRITES = 256;
+const size_t ENVELOPE_RESERVE = 64;  // {"msg_type":..,"msg_body":{..}}
+const int SLOW_READER_BUFFER = 4096;  // SO_RCVBUF of --slow-readers
+
+thread_local std::mt19937 random_engine{std::random_device{}()};
+
+int64_t ToMicros(const std::chrono::steady_clock::time_point& time_point) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             time_point.time_since_epoch())
+      .count();
+}
+
+int64_t GetMicrosNow() { return ToMicros(std::chrono::steady_clock::now()); }
+
+int64_t GetMillisNow() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::chrono::steady_clock::duration ToInterval(const double per_sec) {
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / per_sec));
+}
+
+std::chrono::steady_clock::duration RandomPhase(
+    const std::chrono::steady_clock::duration interval) {
+  std::uniform_int_distribution<int64_t> dist(0, interval.count());
+  return std::chrono::steady_clock::duration(dist(random_engine));
+}
+
+bool ParseValue(const std::string& arg, const std::string& name,
+                std::string* value) {
+  const std::string prefix = "--" + name + "=";
+  if (arg.compare(0, prefix.size(), prefix) != 0) {
+    return false;
+  }
+  *value = arg.substr(prefix.size());
+  return true;
+}
+
+void PrintLatencyRow(const char* name, const LatencyHistogram& histogram) {
+  std::printf("%-9s %10" PRIu64 " %8" PRId64 " %8" PRId64 " %8" PRId64
+              " %8" PRId64 " %8" PRId64 " %8" PRId64 "\n",
+              name, histogram.Count(), histogram.Percentile(50),
+              histogram.Percentile(90), histogram.Percentile(99),
+              histogram.Percentile(99.9), histogram.Percentile(99.99),
+              histogram.Max());
+}
+
+std::vector<std::string> Split(const std::string& v, const char delimiter) {
+  std::vector<std::string> tokens;
+  std::stringstream ss(v);
+  std::string token;
+  while (std::getline(ss, token, delimiter)) {
+    if (!token.empty()) {
+      tokens.emplace_back(token);
+    }
+  }
+  return tokens;
+}
+
+}  // namespace
+
+//:
+//: one simulated user, only touched from its io_context thread
+//:
+class LoadBot : public std::enable_shared_from_this<LoadBot> {
+ public:
+  LoadBot(boost::asio::io_context& io_context, const LoadOptions& options,
+          LoadStats* stats, LatencyStats* latency, const int index,
+          const tcp::endpoint& endpoint, const std::string& local_address)
+      : options_(options),
+        stats_(stats),
+        latency_(latency),
+        index_(index),
+        endpoint_(endpoint),
+        local_address_(local_address),
+        socket_(io_context),
+        connect_timer_(io_context),
+        chat_timer_(io_context),
+        churn_timer_(io_context),
+        read_timer_(io_context),
+        is_connected_(false),
+        is_registered_(false),
+        codec_(Codec::JSON),
+        connect_scheduled_usec_(0),
+        next_seq_(1) {}
+
+  void Start(const std::chrono::steady_clock::duration delay) {
+    auto self(shared_from_this());
+    connect_scheduled_usec_ =
+        ToMicros(std::chrono::steady_clock::now() + delay);
+    connect_timer_.expires_after(delay);
+    connect_timer_.async_wait([this, self](boost::system::error_code ec) {
+      if (!ec) {
+        Connect();
+      }
+    });
+  }
+
+  void Stop() {
+    auto self(shared_from_this());
+    boost::asio::post(socket_.get_executor(), [this, self]() { Close(); });
+  }
+
+ private:
+  void Connect() {
+    boost::system::error_code ec;
+    socket_.open(tcp::v4(), ec);
+    if (!ec && index_ < options_.slow_readers) {
+      // a small window, or the kernel buffers hide the backlog from the server
+      socket_.set_option(tcp::socket::receive_buffer_size(SLOW_READER_BUFFER),
+                         ec);
+    }
+    if (!ec && !local_address_.empty()) {
+      socket_.bind(
+          tcp::endpoint(boost::asio::ip::make_address(local_address_), 0), ec);
+    }
+    if (ec) {
+      ++stats_->connect_failed;
+      socket_.close(ec);
+      return;
+    }
+
+    ++stats_->connecting;
+    auto self(shared_from_this());
+    socket_.async_connect(endpoint_,
+                          [this, self](boost::system::error_code ec) {
+                            --stats_->connecting;
+                            if (ec) {
+                              ++stats_->connect_failed;
+                              Close();
+                              return;
+                            }
+                            OnConnected();
+                          });
+  }
+
+  void OnConnected() {
+    is_connected_ = true;
+    ++stats_->connected;
+    ReadHeader();
+
+    if (!options_.binary_codec) {
+      Begin();
+      return;
+    }
+    // nothing else goes out before the ack, the server may switch codecs
+    Protocol::Hello hello;
+    hello.codec = static_cast<int>(Codec::BINARY);
+    Send(SimpleMessage::MakeMessage(hello, codec_));
+  }
+
+  void OnHelloAck() {
+    codec_ = static_cast<Codec>(hello_ack_.codec);
+    Begin();
+  }
+
+  void Begin() {
+    Protocol::Register request;
+    request.nickname = "bot" + std::to_string(index_);
+    Send(SimpleMessage::MakeMessage(request, codec_));
+    EnterRoom();
+
+    const auto now = std::chrono::steady_clock::now();
+    if (options_.chat_per_sec > 0) {
+      chat_interval_ = ToInterval(options_.chat_per_sec);
+      next_chat_ = now + RandomPhase(chat_interval_);
+      ScheduleChat();
+    }
+    if (options_.churn_per_sec > 0) {
+      churn_interval_ = ToInterval(options_.churn_per_sec);
+      next_churn_ = now + churn_interval_ + RandomPhase(churn_interval_);
+      ScheduleChurn();
+    }
+  }
+
+  void ScheduleChat() {
+    auto self(shared_from_this());
+    chat_timer_.expires_at(next_chat_);
+    chat_timer_.async_wait([this, self](boost::system::error_code ec) {
+      if (ec || !is_connected_) {
+        return;
+      }
+      // open loop: a late tick doesn't push the following ones back and
+      // its latency still counts from the scheduled time
+      for (int i = 0; i < options_.burst_size; ++i) {
+        SendChat(next_chat_);
+      }
+      next_chat_ += chat_interval_;
+      ScheduleChat();
+    });
+  }
+
+  void ScheduleChurn() {
+    auto self(shared_from_this());
+    churn_timer_.expires_at(next_churn_);
+    churn_timer_.async_wait([this, self](boost::system::error_code ec) {
+      if (ec || !is_connected_) {
+        return;
+      }
+      ExitRoom();
+      EnterRoom();
+      ++stats_->room_changes;
+      next_churn_ += churn_interval_;
+      ScheduleChurn();
+    });
+  }
+
+  //: a chat that finds the write queue full waits in deferred_chats_ and
+  //: goes out late, its latencies still count from the scheduled time
+  void SendChat(const std::chrono::steady_clock::time_point& scheduled) {
+    const int64_t scheduled_usec = ToMicros(scheduled);
+    if (!deferred_chats_.empty() ||
+        write_msgs_.size() >= MAX_PENDING_WRITES) {
+      deferred_chats_.push_back(scheduled_usec);
+      ++stats_->send_deferred;
+      return;
+    }
+    WriteChat(scheduled_usec);
+  }
+
+  void SendDeferredChats() {
+    while (!deferred_chats_.empty() &&
+           write_msgs_.size() < MAX_PENDING_WRITES) {
+      const int64_t scheduled_usec = deferred_chats_.front();
+      deferred_chats_.pop_front();
+      WriteChat(scheduled_usec);
+    }
+  }
+
+  void WriteChat(const int64_t scheduled_usec) {
+    latency_->send_lag_usec.Record(GetMicrosNow() - scheduled_usec);
+
+    // #<sender>:<seq>:<scheduled usec># padded up to message_size
+    char header[64] = "";
+    std::snprintf(header, sizeof(header), "#%d:%" PRIu32 ":%" PRId64 "#",
+                  index_, next_seq_, scheduled_usec);
+    Protocol::SendChat request;
+    request.chat_message = header;
+    const size_t size =
+        std::min(options_.message_size,
+                 static_cast<size_t>(SimpleMessage::max_body_length) -
+                     ENVELOPE_RESERVE);
+    if (request.chat_message.size() < size) {
+      request.chat_message.append(size - request.chat_message.size(), 'x');
+    }
+
+    if (!Send(SimpleMessage::MakeMessage(request, codec_))) {
+      return;
+    }
+    pending_acks_.push_back(scheduled_usec);
+    ++next_seq_;
+  }
+
+  void EnterRoom() {
+    Send(SimpleMessage::MakeMessage(Protocol::EnterRoom(), codec_));
+  }
+
+  void ExitRoom() {
+    // sequences restart from whatever the next room delivers
+    senders_.clear();
+
+    Send(SimpleMessage::MakeMessage(Protocol::ExitRoom(), codec_));
+  }
+
+  bool Send(const SimpleMessage& msg) {
+    if (write_msgs_.size() >= MAX_PENDING_WRITES) {
+      ++stats_->send_dropped;
+      return false;
+    }
+    const bool write_in_progress = !write_msgs_.empty();
+    write_msgs_.push_back(msg);
+    if (!write_in_progress) {
+      Write();
+    }
+    return true;
+  }
+
+  void Write() {
+    auto self(shared_from_this());
+    boost::asio::async_write(
+        socket_,
+        boost::asio::buffer(write_msgs_.front().data(),
+                            write_msgs_.front().length()),
+        [this, self](boost::system::error_code ec, std::size_t /*length*/) {
+          if (ec) {
+            Close();
+            return;
+          }
+          ++stats_->sent;
+          write_msgs_.pop_front();
+          if (!write_msgs_.empty()) {
+            Write();
+          }
+          SendDeferredChats();
+        });
+  }
+
+  void ReadHeader() {
+    auto self(shared_from_this());
+    boost::asio::async_read(
+        socket_,
+        boost::asio::buffer(read_msg_.data(), SimpleMessage::header_length),
+        [this, self](boost::system::error_code ec, std::size_t /*length*/) {
+          if (!ec && read_msg_.decode_header()) {
+            ReadBody();
+          } else {
+            Close();
+          }
+        });
+  }
+
+  void ReadBody() {
+    auto self(shared_from_this());
+    boost::asio::async_read(
+        socket_, boost::asio::buffer(read_msg_.body(), read_msg_.body_length()),
+        [this, self](boost::system::error_code ec, std::size_t /*length*/) {
+          if (ec) {
+            Close();
+            return;
+          }
+          OnMessage();
+          if (index_ < options_.slow_readers) {
+            ReadLater();
+          } else {
+            ReadHeader();
+          }
+        });
+  }
+
+  //: a peer on a bad network, the server's outbound queue backs up
+  void ReadLater() {
+    auto self(shared_from_this());
+    read_timer_.expires_after(
+        std::chrono::milliseconds(options_.read_delay_msec));
+    read_timer_.async_wait([this, self](boost::system::error_code ec) {
+      if (!ec) {
+        ReadHeader();
+      }
+    });
+  }
+
+  void OnMessage() {
+    ++stats_->received;
+
+    MessageEnvelope envelope;
+    if (Envelope::Parse(read_msg_.body(), read_msg_.body_length(),
+                        [](const int) { return true; },
+                        &envelope) != Envelope::Result::OK) {
+      ++stats_->malformed;
+      return;
+    }
+
+    switch (static_cast<MessageType>(envelope.msg_type)) {
+      case MessageType::HelloAck:
+        if (Decode(envelope, &hello_ack_)) {
+          OnHelloAck();
+        }
+        break;
+      case MessageType::RegisterAck:
+        if (Decode(envelope, &register_ack_)) {
+          OnRegisterAck();
+        }
+        break;
+      case MessageType::EnterRoomAck:
+        Decode(envelope, &enter_room_ack_);
+        break;
+      case MessageType::ExitRoomAck:
+        Decode(envelope, &exit_room_ack_);
+        break;
+      case MessageType::SendChatAck:
+        if (Decode(envelope, &chat_ack_)) {
+          OnChatAck();
+        }
+        break;
+      case MessageType::BroadcastingChat:
+        if (Decode(envelope, &broadcast_)) {
+          OnBroadcastingChat(broadcast_.chat_message);
+        }
+        break;
+      case MessageType::BroadcastingChatBatch:
+        if (Decode(envelope, &broadcast_batch_)) {
+          for (const auto& chat_message : broadcast_batch_.chat_messages) {
+            OnBroadcastingChat(chat_message);
+          }
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  //: every server message carries a result
+  template <typename T>
+  bool Decode(const MessageEnvelope& envelope, T* msg) {
+    if (!MessageBody(envelope).Decode(msg)) {
+      ++stats_->malformed;
+      return false;
+    }
+    if (msg->result != static_cast<int>(ResultType::Sucess)) {
+      ++stats_->error_acks;
+    }
+    return true;
+  }
+
+  void OnRegisterAck() {
+    if (is_registered_) {
+      return;
+    }
+    is_registered_ = true;
+    latency_->register_usec.Record(GetMicrosNow() - connect_scheduled_usec_);
+  }
+
+  void OnChatAck() {
+    // the server answers one session in request order
+    if (pending_acks_.empty()) {
+      return;
+    }
+    latency_->ack_usec.Record(GetMicrosNow() - pending_acks_.front());
+    pending_acks_.pop_front();
+  }
+
+  void OnBroadcastingChat(const std::string& chat_message) {
+    int sender = 0;
+    uint32_t seq = 0;
+    int64_t scheduled_usec = 0;
+    if (std::sscanf(chat_message.c_str(), "#%d:%" SCNu32 ":%" SCNd64 "#",
+                    &sender, &seq, &scheduled_usec) != 3) {
+      return;  // not sent by a load bot
+    }
+    latency_->delivery_usec.Record(GetMicrosNow() - scheduled_usec);
+    ++latency_->delivered;
+
+    auto it = senders_.find(sender);
+    if (it == senders_.end()) {
+      senders_.emplace(sender, seq);
+    } else if (seq > it->second) {
+      latency_->missing += seq - it->second - 1;
+      it->second = seq;
+    } else if (seq < it->second) {
+      ++latency_->reordered;
+      if (latency_->missing > 0) {
+        --latency_->missing;
+      }
+    } else {
+      ++latency_->duplicated;
+    }
+  }
+
+  void Close() {
+    boost::system::error_code ec;
+    connect_timer_.cancel();
+    chat_timer_.cancel();
+    churn_timer_.cancel();
+    read_timer_.cancel();
+    if (is_connected_) {
+      is_connected_ = false;
+      ++stats_->disconnected;
+    }
+    latency_->unacked += pending_acks_.size();
+    pending_acks_.clear();
+    latency_->unsent += deferred_chats_.size();
+    deferred_chats_.clear();
+    socket_.close(ec);
+  }
+
+  const LoadOptions& options_;
+  LoadStats* stats_;
+  LatencyStats* latency_;
+  const int index_;
+  const tcp::endpoint endpoint_;
+  const std::string local_address_;
+
+  tcp::socket socket_;
+  boost::asio::steady_timer connect_timer_;
+  boost::asio::steady_timer chat_timer_;
+  boost::asio::steady_timer churn_timer_;
+  boost::asio::steady_timer read_timer_;
+  std::chrono::steady_clock::duration chat_interval_;
+  std::chrono::steady_clock::duration churn_interval_;
+  std::chrono::steady_clock::time_point next_chat_;
+  std::chrono::steady_clock::time_point next_churn_;
+
+  bool is_connected_;
+  bool is_registered_;
+  Codec codec_;  // what the bot sends, the server's frames are sniffed
+  int64_t connect_scheduled_usec_;
+  SimpleMessage read_msg_;
+  std::deque<SimpleMessage> write_msgs_;
+
+  // decode targets, reused so their strings keep the capacity
+  Protocol::HelloAck hello_ack_;
+  Protocol::RegisterAck register_ack_;
+  Protocol::EnterRoomAck enter_room_ack_;
+  Protocol::ExitRoomAck exit_room_ack_;
+  Protocol::SendChatAck chat_ack_;
+  Protocol::BroadcastingChat broadcast_;
+  Protocol::BroadcastingChatBatch broadcast_batch_;
+
+  uint32_t next_seq_;
+  std::deque<int64_t> pending_acks_;           // scheduled send usec
+  std::deque<int64_t> deferred_chats_;         // scheduled send usec
+  std::unordered_map<int, uint32_t> senders_;  // sender -> last seq seen
+};
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+bool ParseLoadOptions(int argc, char* argv[], LoadOptions* options) {
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      std::string value;
+      if (arg == "--load") {
+        options->enabled = true;
+      } else if (ParseValue(arg, "host", &value)) {
+        options->host = value;
+      } else if (ParseValue(arg, "port", &value)) {
+        options->port = value;
+      } else if (ParseValue(arg, "local-addresses", &value)) {
+        options->local_addresses = Split(value, ',');
+      } else if (ParseValue(arg, "connections", &value)) {
+        options->connections = std::stoi(value);
+      } else if (ParseValue(arg, "io-threads", &value)) {
+        options->io_threads = std::max(1, std::stoi(value));
+      } else if (ParseValue(arg, "connect-rate", &value)) {
+        options->connect_per_sec = std::stod(value);
+      } else if (ParseValue(arg, "chat-rate", &value)) {
+        options->chat_per_sec = std::stod(value);
+      } else if (ParseValue(arg, "burst", &value)) {
+        options->burst_size = std::max(1, std::stoi(value));
+      } else if (ParseValue(arg, "churn-rate", &value)) {
+        options->churn_per_sec = std::stod(value);
+      } else if (ParseValue(arg, "slow-readers", &value)) {
+        options->slow_readers = std::stoi(value);
+      } else if (ParseValue(arg, "read-delay", &value)) {
+        options->read_delay_msec = std::stoi(value);
+      } else if (ParseValue(arg, "message-size", &value)) {
+        options->message_size = static_cast<size_t>(std::stoul(value));
+      } else if (ParseValue(arg, "codec", &value)) {
+        if (value != "json" && value != "binary") {
+          return false;
+        }
+        options->binary_codec = (value == "binary");
+      } else if (ParseValue(arg, "duration", &value)) {
+        options->duration_sec = std::stoi(value);
+      } else if (ParseValue(arg, "replay", &value)) {
+        options->replay_path = value;
+      } else if (ParseValue(arg, "speed", &value)) {
+        options->replay_speed = std::max(0.0, std::stod(value));
+      } else {
+        return false;
+      }
+    }
+  } catch (const std::exception&) {
+    return false;
+  }
+  return options->connect_per_sec > 0;
+}
+
+void PrintLoadUsage() {
+  std::cerr
+      << "usage: DummyClient [--host=127.0.0.1] [--port=5959]\n"
+         "       DummyClient --load [options]\n"
+         "       DummyClient --replay=<capture> [--speed=1] [--io-threads=4]\n"
+         "  --connections=<n>        simulated users (1000)\n"
+         "  --io-threads=<n>         io_context threads (4)\n"
+         "  --connect-rate=<n/s>     connect ramp (1000)\n"
+         "  --chat-rate=<n/s>        chats per user per second (1)\n"
+         "  --burst=<n>              chats sent back to back per tick (1)\n"
+         "  --churn-rate=<n/s>       room exit+enter per user per second (0)\n"
+         "  --slow-readers=<n>       bots that wait between frames read (0)\n"
+         "  --read-delay=<msec>      how long a slow reader waits (0)\n"
+         "  --message-size=<bytes>   chat message length (32)\n"
+         "  --codec=<json|binary>    what the bots ask the server for (json)\n"
+         "  --duration=<sec>         stop after sec, 0 waits for 'q' (0)\n"
+         "  --local-addresses=a,b    source addresses to bind round robin,\n"
+         "                           each one gives another ~28k ports\n"
+         "  --speed=<x>              replay time scale, 0 = no waiting (1)\n";
+}
+
+void LatencyStats::Merge(const LatencyStats& other) {
+  register_usec.Merge(other.register_usec);
+  ack_usec.Merge(other.ack_usec);
+  delivery_usec.Merge(other.delivery_usec);
+  send_lag_usec.Merge(other.send_lag_usec);
+  delivered += other.delivered;
+  missing += other.missing;
+  reordered += other.reordered;
+  duplicated += other.duplicated;
+  unacked += other.unacked;
+  unsent += other.unsent;
+}
+
+LoadGenerator::LoadGenerator(const LoadOptions& options)
+    : options_(options),
+      start_msec_(0),
+      stop_msec_(0),
+      last_sent_(0),
+      last_received_(0),
+      last_status_msec_(0) {}
+
+LoadGenerator::~LoadGenerator() { Stop(); }
+
+bool LoadGenerator::Start() {
+  for (int i = 0; i < options_.io_threads; ++i) {
+    io_contexts_.emplace_back(std::make_unique<boost::asio::io_context>(1));
+    work_guards_.emplace_back(std::make_unique<WorkGuard>(
+        boost::asio::make_work_guard(*io_contexts_.back())));
+    latency_stats_.emplace_back(std::make_unique<LatencyStats>());
+  }
+
+  tcp::endpoint endpoint;
+  try {
+    tcp::resolver resolver(*io_contexts_.front());
+    endpoint = *resolver.resolve(tcp::v4(), options_.host, options_.port)
+                    .begin();
+  } catch (const std::exception& e) {
+    std::cerr << "resolve failed: " << e.what() << "\n";
+    return false;
+  }
+
+  const auto ramp_interval = ToInterval(options_.connect_per_sec);
+  bots_.reserve(options_.connections);
+  for (int i = 0; i < options_.connections; ++i) {
+    const size_t context_index = i % io_contexts_.size();
+    const std::string local_address =
+        options_.local_addresses.empty()
+            ? ""
+            : options_.local_addresses[i % options_.local_addresses.size()];
+    bots_.emplace_back(std::make_shared<LoadBot>(
+        *io_contexts_[context_index], options_, &stats_,
+        latency_stats_[context_index].get(), i, endpoint, local_address));
+    bots_.back()->Start(ramp_interval * i);
+  }
+
+  start_msec_ = GetMillisNow();
+  last_status_msec_ = start_msec_;
+  thread_cpu_sec_.assign(io_contexts_.size(), 0.0);
+  for (size_t i = 0; i < io_contexts_.size(); ++i) {
+    auto context = io_contexts_[i].get();
+    auto cpu_sec = &thread_cpu_sec_[i];
+    threads_.emplace_back(
+        std::make_unique<boost::thread>([context, cpu_sec]() {
+          const auto begin = boost::chrono::thread_clock::now();
+          context->run();
+          *cpu_sec = boost::chrono::duration<double>(
+                         boost::chrono::thread_clock::now() - begin)
+                         .count();
+        }));
+  }
+  return true;
+}
+
+void LoadGenerator::Stop() {
+  if (!threads_.empty()) {
+    stop_msec_ = GetMillisNow();
+  }
+  for (auto& bot : bots_) {
+    bot->Stop();
+  }
+  for (auto& work_guard : work_guards_) {
+    work_guard->reset();
+  }
+  for (auto& thread : threads_) {
+    if (!!thread && thread->joinable()) {
+      thread->join();
+    }
+  }
+  threads_.clear();
+  work_guards_.clear();
+  bots_.clear();
+  io_contexts_.clear();
+  // latency_stats_ stays for GetSummary()
+}
+
+void LoadGenerator::PrintStatus() {
+  const int64_t now_msec = GetMillisNow();
+  const double elapsed_sec =
+      std::max<int64_t>(1, now_msec - last_status_msec_) / 1000.0;
+  const uint64_t sent = stats_.sent.load();
+  const uint64_t received = stats_.received.load();
+
+  std::printf(
+      "[%6.1fs] connected %llu/%d (connecting %llu, failed %llu, closed "
+      "%llu) sent %.0f/s received %.0f/s\n",
+      (now_msec - start_msec_) / 1000.0,
+      static_cast<unsigned long long>(stats_.connected.load()),
+      options_.connections,
+      static_cast<unsigned long long>(stats_.connecting.load()),
+      static_cast<unsigned long long>(stats_.connect_failed.load()),
+      static_cast<unsigned long long>(stats_.disconnected.load()),
+      (sent - last_sent_) / elapsed_sec,
+      (received - last_received_) / elapsed_sec);
+  std::fflush(stdout);
+
+  last_sent_ = sent;
+  last_received_ = received;
+  last_status_msec_ = now_msec;
+}
+
+LoadSummary LoadGenerator::GetSummary() const {
+  LoadSummary summary;
+  const int64_t end_msec = stop_msec_ != 0 ? stop_msec_ : GetMillisNow();
+  summary.elapsed_sec = std::max<int64_t>(1, end_msec - start_msec_) / 1000.0;
+  summary.client_cpu_sec = 0.0;
+  for (const double cpu_sec : thread_cpu_sec_) {
+    summary.client_cpu_sec += cpu_sec;
+  }
+  summary.connected = stats_.connected.load();
+  summary.connect_failed = stats_.connect_failed.load();
+  summary.disconnected = stats_.disconnected.load();
+  summary.sent = stats_.sent.load();
+  summary.send_dropped = stats_.send_dropped.load();
+  summary.send_deferred = stats_.send_deferred.load();
+  summary.received = stats_.received.load();
+  summary.malformed = stats_.malformed.load();
+  summary.error_acks = stats_.error_acks.load();
+  summary.room_changes = stats_.room_changes.load();
+  for (const auto& latency : latency_stats_) {
+    summary.latency.Merge(*latency);
+  }
+  return summary;
+}
+
+void LoadGenerator::PrintReport() {
+  const LoadSummary summary = GetSummary();
+  const LatencyStats& total = summary.latency;
+  std::printf(
+      "\n---- load report ----\n"
+      "duration        : %.1fs (client cpu %.2fs)\n"
+      "connected       : %" PRIu64 " (failed %" PRIu64 ", closed %" PRIu64
+      ")\n"
+      "frames sent     : %" PRIu64 " (%.0f/s, dropped %" PRIu64
+      ", chats deferred %" PRIu64 ")\n"
+      "frames received : %" PRIu64 " (%.0f/s, malformed %" PRIu64 ")\n"
+      "error acks      : %" PRIu64 "\n"
+      "room changes    : %" PRIu64 "\n",
+      summary.elapsed_sec, summary.client_cpu_sec, summary.connected,
+      summary.connect_failed, summary.disconnected, summary.sent,
+      summary.sent / summary.elapsed_sec, summary.send_dropped,
+      summary.send_deferred,
+      summary.received, summary.received / summary.elapsed_sec,
+      summary.malformed, summary.error_acks, summary.room_changes);
+
+  std::printf("\n---- latency from scheduled send (usec) ----\n");
+  std::printf("%-9s %10s %8s %8s %8s %8s %8s %8s\n", "", "count", "p50",
+              "p90", "p99", "p99.9", "p99.99", "max");
+  PrintLatencyRow("register", total.register_usec);
+  PrintLatencyRow("ack", total.ack_usec);
+  PrintLatencyRow("delivery", total.delivery_usec);
+  PrintLatencyRow("send lag", total.send_lag_usec);
+
+  const uint64_t expected = total.delivered + total.missing;
+  std::printf(
+      "\n---- delivery ----\n"
+      "delivered       : %" PRIu64 "\n"
+      "missing         : %" PRIu64 " (%.4f%%)\n"
+      "reordered       : %" PRIu64 "\n"
+      "duplicated      : %" PRIu64 "\n"
+      "unacked chats   : %" PRIu64 "\n"
+      "unsent chats    : %" PRIu64 "\n",
+      total.delivered, total.missing,
+      expected == 0 ? 0.0 : 100.0 * total.missing / expected, total.reordered,
+      total.duplicated, total.unacked, total.unsent);
+  std::fflush(stdout);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "latency_histogram.h"
+
+//:
+//: command line options of DummyClient
+//: without --load or --replay it runs the interactive chat client on host:port
+//:
+struct LoadOptions {
+  bool enabled = false;
+  std::string host = "127.0.0.1";
+  std::string port = "5959";
+  std::vector<std::string> local_addresses;  // bound round robin
+  int connections = 1000;
+  int io_threads = 4;
+  double connect_per_sec = 1000.0;
+  double chat_per_sec = 1.0;   // per connection
+  int burst_size = 1;          // chats sent back to back per tick
+  double churn_per_sec = 0.0;  // exit + enter room, per connection
+  int slow_readers = 0;        // the first n bots wait between frames
+  int read_delay_msec = 0;     // how long a slow reader waits
+  size_t message_size = 32;
+  bool binary_codec = false;  // asked for with a Hello before Register
+  int duration_sec = 0;  // 0 runs until 'q'
+  std::string replay_path;    // server capture file, see replay.h
+  double replay_speed = 1.0;  // 0 sends as fast as possible
+};
+
+bool ParseLoadOptions(int argc, char* argv[], LoadOptions* options);
+void PrintLoadUsage();
+
+struct LoadStats {
+  std::atomic<uint64_t> connecting{0};
+  std::atomic<uint64_t> connected{0};
+  std::atomic<uint64_t> connect_failed{0};
+  std::atomic<uint64_t> disconnected{0};
+  std::atomic<uint64_t> sent{0};
+  std::atomic<uint64_t> send_dropped{0};   // frames other than chats
+  std::atomic<uint64_t> send_deferred{0};  // chats that waited for a write
+  std::atomic<uint64_t> received{0};
+  std::atomic<uint64_t> malformed{0};
+  std::atomic<uint64_t> error_acks{0};
+  std::atomic<uint64_t> room_changes{0};
+};
+
+//:
+//: latency and delivery accounting of one io_context, merged for the report
+//: latencies start at the scheduled send time, so a stalled sender or
+//: server can't hide its delay (coordinated omission)
+//:
+struct LatencyStats {
+  LatencyHistogram register_usec;  // scheduled connect -> RegisterAck
+  LatencyHistogram ack_usec;       // scheduled send -> SendChatAck
+  LatencyHistogram delivery_usec;  // scheduled send -> BroadcastingChat
+  LatencyHistogram send_lag_usec;  // scheduled send -> queued for write
+  uint64_t delivered = 0;
+  uint64_t missing = 0;     // sequence gaps not filled later
+  uint64_t reordered = 0;   // arrived after a later sequence of its sender
+  uint64_t duplicated = 0;
+  uint64_t unacked = 0;  // chats still waiting for their ack at stop
+  uint64_t unsent = 0;   // chats still deferred at stop
+
+  void Merge(const LatencyStats& other);
+};
+
+//:
+//: snapshot of a finished run, for callers that report on their own
+//:
+struct LoadSummary {
+  double elapsed_sec;
+  double client_cpu_sec;  // io threads of the generator
+  uint64_t connected;
+  uint64_t connect_failed;
+  uint64_t disconnected;
+  uint64_t sent;
+  uint64_t send_dropped;
+  uint64_t send_deferred;
+  uint64_t received;
+  uint64_t malformed;
+  uint64_t error_acks;
+  uint64_t room_changes;
+  LatencyStats latency;
+};
+
+class LoadBot;
+
+//:
+//: asio driven load generator
+//: every bot is a socket plus timers on one of io_threads io_contexts,
+//: so the connection count is bounded by descriptors and ports, not threads
+//:
+class LoadGenerator {
+ public:
+  explicit LoadGenerator(const LoadOptions& options);
+  ~LoadGenerator();
+
+  bool Start();
+  void Stop();
+
+  void PrintStatus();
+  void PrintReport();
+
+  //: valid after Stop()
+  LoadSummary GetSummary() const;
+
+ private:
+  using WorkGuard =
+      boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+  LoadOptions options_;
+  LoadStats stats_;
+  int64_t start_msec_;
+  int64_t stop_msec_;
+  uint64_t last_sent_;
+  uint64_t last_received_;
+  int64_t last_status_msec_;
+
+  std::vector<std::unique_ptr<boost::asio::io_context>> io_contexts_;
+  std::vector<std::unique_ptr<WorkGuard>> work_guards_;
+  std::vector<std::unique_ptr<LatencyStats>> latency_stats_;
+  std::vector<double> thread_cpu_sec_;
+  std::vector<std::unique_ptr<boost::thread>> threads_;
+  std::vector<std::shared_ptr<LoadBot>> bots_;
+};
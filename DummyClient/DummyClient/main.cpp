@@ -9,12 +9,16 @@
 //
 
 #include <boost/asio.hpp>
-#include <boost/lexical_cast.hpp>
 #include <boost/thread.hpp>
+#include <chrono>
 #include <cstdlib>
 #include <deque>
 #include <iostream>
+#include <thread>
 
+#include "load_generator.h"
+#include "messages.h"
+#include "replay.h"
 #include "simple_message.h"
 
 using boost::asio::ip::tcp;
@@ -72,10 +76,8 @@ class chat_client {
         socket_, boost::asio::buffer(read_msg_.body(), read_msg_.body_length()),
         [this](boost::system::error_code ec, std::size_t /*length*/) {
           if (!ec) {
-#if !AUTO_BOT
             std::cout.write(read_msg_.body(), read_msg_.body_length());
             std::cout << "\n";
-#endif
             do_read_header();
           } else {
             socket_.close();
@@ -107,84 +109,56 @@ class chat_client {
   chat_message_queue write_msgs_;
 };
 
-std::atomic<int> counter = 1;
-
-void RunBot(const std::shared_ptr<chat_client>& c) {
-  std::string nickname{"bot" +
-                       boost::lexical_cast<std::string>(counter.load())};
-  Json register_doc;
-  register_doc.SetObject();
-  register_doc.SetAttribute("nickname", nickname);
-  auto register_req = SimpleMessage::MakeMessage(
-      static_cast<int>(MessageType::Register), register_doc);
-  c->write(register_req);
-
-  Json enter_room_doc;
-  enter_room_doc.SetObject();
-  auto enter_room_req = SimpleMessage::MakeMessage(
-      static_cast<int>(MessageType::EnterRoom), enter_room_doc);
-  c->write(enter_room_req);
+int RunLoadGenerator(const LoadOptions& options) {
+  LoadGenerator generator(options);
+  if (!generator.Start()) {
+    return 1;
+  }
 
-  std::this_thread::sleep_for(std::chrono::seconds(1));
+  std::atomic<bool> quit{false};
+  if (options.duration_sec == 0) {
+    boost::thread([&quit]() {
+      std::string line;
+      while (std::getline(std::cin, line)) {
+        if (!line.empty() && line[0] == 'q') {
+          break;
+        }
+      }
+      quit = true;
+    }).detach();
+  }
 
-  try {
-    while (true) {
-      boost::this_thread::interruption_point();
-
-      std::string blah{"blah... blah... blah..."};
-      Json chat_doc;
-      chat_doc.SetObject();
-      chat_doc.SetAttribute("chat_message",
-                            boost::lexical_cast<std::string>(blah));
-      auto req = SimpleMessage::MakeMessage(
-          static_cast<int>(MessageType::SendChat), chat_doc);
-      c->write(req);
-      std::this_thread::sleep_for(std::chrono::seconds(1));
+  for (int sec = 1; !quit; ++sec) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    generator.PrintStatus();
+    if (options.duration_sec > 0 && sec >= options.duration_sec) {
+      break;
     }
-  } catch (...) {
   }
-}
 
-#define AUTO_BOT 0
-#define AUTO_BOT_SIZE 100
+  generator.Stop();
+  generator.PrintReport();
+  return 0;
+}
 
 int main(int argc, char* argv[]) {
+  LoadOptions options;
+  if (!ParseLoadOptions(argc, argv, &options)) {
+    PrintLoadUsage();
+    return 1;
+  }
+  if (options.enabled) {
+    return RunLoadGenerator(options);
+  }
+  if (!options.replay_path.empty()) {
+    return RunReplay(options);
+  }
+
   try {
     boost::asio::io_context io_context;
 
-#if AUTO_BOT
-    tcp::resolver resolver(io_context);
-    auto endpoints = resolver.resolve("127.0.0.1", "5959");
-    std::vector<std::shared_ptr<chat_client>> clients;
-    for (int i = 0; i < AUTO_BOT_SIZE; ++i) {
-      clients.emplace_back(
-          std::make_shared<chat_client>(io_context, endpoints));
-    }
-    boost::thread t([&io_context]() { io_context.run(); });
-
-    std::vector<std::unique_ptr<boost::thread>> threads;
-    for (int i = 0; i < AUTO_BOT_SIZE; ++i) {
-      auto client = clients[i];
-      threads.emplace_back(std::make_unique<boost::thread>(
-          [client]() mutable { RunBot(client); }));
-    }
-    char line[10];
-    while (std::cin.getline(line, 10)) {
-      if (line[0] == 'q') {
-        break;
-      }
-    }
-    io_context.stop();
-    t.join();
-    for (auto& thread : threads) {
-      if (!!thread && thread->joinable()) {
-        thread->interrupt();
-        thread->join();
-      }
-    }
-#else
     tcp::resolver resolver(io_context);
-    auto endpoints = resolver.resolve("127.0.0.1", "5959");
+    auto endpoints = resolver.resolve(options.host, options.port);
     chat_client c(io_context, endpoints);
 
     boost::thread t([&io_context]() { io_context.run(); });
@@ -192,19 +166,14 @@ int main(int argc, char* argv[]) {
     std::cout << "input your nickname:";
     char nickname[50];
     std::cin.getline(nickname, 50);
-    Json register_doc;
-    register_doc.SetObject();
-    register_doc.SetAttribute("nickname", nickname);
-    auto register_req = SimpleMessage::MakeMessage(
-        static_cast<int>(MessageType::Register), register_doc);
+    Protocol::Register register_doc;
+    register_doc.nickname = nickname;
+    auto register_req = SimpleMessage::MakeMessage(register_doc);
     std::cout << register_req.body() << std::endl;
     c.write(register_req);
     std::cout << "send register" << std::endl;
 
-    Json enter_room_doc;
-    enter_room_doc.SetObject();
-    auto enter_room_req = SimpleMessage::MakeMessage(
-        static_cast<int>(MessageType::EnterRoom), enter_room_doc);
+    auto enter_room_req = SimpleMessage::MakeMessage(Protocol::EnterRoom());
     std::cout << enter_room_req.body() << std::endl;
     c.write(enter_room_req);
     std::cout << "send enter room" << std::endl;
@@ -213,28 +182,21 @@ int main(int argc, char* argv[]) {
     char line[SimpleMessage::max_body_length + 1];
     while (std::cin.getline(line, SimpleMessage::max_body_length + 1)) {
       if (line[0] == 'q') {
-        Json exit_doc;
-        exit_doc.SetObject();
-        auto req = SimpleMessage::MakeMessage(
-            static_cast<int>(MessageType::ExitRoom), exit_doc);
+        auto req = SimpleMessage::MakeMessage(Protocol::ExitRoom());
         c.write(req);
-        Sleep(1000);
+        std::this_thread::sleep_for(std::chrono::seconds(1));
         break;
       }
 
-      Json chat_doc;
-      chat_doc.SetObject();
-      chat_doc.SetAttribute("chat_message",
-                            boost::lexical_cast<std::string>(line));
-      auto req = SimpleMessage::MakeMessage(
-          static_cast<int>(MessageType::SendChat), chat_doc);
+      Protocol::SendChat chat_doc;
+      chat_doc.chat_message = line;
+      auto req = SimpleMessage::MakeMessage(chat_doc);
 
       c.write(req);
     }
     c.close();
     io_context.stop();
     t.join();
-#endif
   } catch (std::exception& e) {
     std::cerr << "Exception: " << e.what() << "\n";
   }
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+#include "simple_message.h"
+
+//:
+//: msg_type and the raw msg_body of one frame
+//: body points into the parsed buffer and lives as long as that does
+//:
+struct MessageEnvelope {
+  Codec codec;
+  int msg_type;
+  const char* body;
+  std::size_t body_length;
+};
+
+namespace Envelope {
+
+enum class Result {
+  OK,
+  MALFORMED,
+  REJECTED,
+};
+
+//:
+//: reads {"msg_type":N,"msg_body":...} in one SAX pass without a DOM, or
+//: the MessagePack [N, body] of a BINARY frame, whichever the first byte is
+//: accept is asked as soon as msg_type is read, false stops the parse there
+//: and the frame comes back REJECTED
+//:
+Result Parse(const char* data, const std::size_t length,
+             const std::function<bool(const int)>& accept,
+             MessageEnvelope* envelope);
+
+}  // namespace Envelope
+
+//:
+//: msg_body as a message handler sees it, only parsed when the handler
+//: decodes it into one of the structs in messages.h
+//:
+class MessageBody {
+ public:
+  MessageBody(const Codec codec, const char* data, const std::size_t length)
+      : codec_(codec), data_(data), length_(length) {}
+  explicit MessageBody(const MessageEnvelope& envelope)
+      : MessageBody(envelope.codec, envelope.body, envelope.body_length) {}
+
+  Codec GetCodec() const { return codec_; }
+  const char* GetData() const { return data_; }
+  std::size_t GetLength() const { return length_; }
+
+  template <typename T>
+  bool Decode(T* msg) const {
+    if (codec_ == Codec::BINARY) {
+      return msg->DecodeBinary(data_, length_);
+    }
+    return msg->DecodeJson(data_, length_);
+  }
+
+ private:
+  const Codec codec_;
+  const char* data_;
+  std::size_t length_;
+};
@@ -0,0 +1,560 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+#include "message_envelope.h"
+#include "messages.h"
+#include "simple_message.h"
+
+using boost::asio::ip::tcp;
+
+namespace {
+
+const char FILE_MAGIC[] = "SACAP001";
+const uint8_t RECORD_FRAME = 1;
+const uint8_t RECORD_CLOSE = 2;
+const int CONNECT_TIMEOUT_SEC = 30;
+const int DRAIN_TIMEOUT_SEC = 10;  // after the last scheduled frame
+const auto START_DELAY = std::chrono::milliseconds(100);
+
+struct CaptureRecord {
+  int64_t offset_usec;  // since the capture started
+  bool is_close;
+  int msg_type;
+  std::string body;
+};
+
+using CaptureConnection = std::vector<CaptureRecord>;
+
+struct ReplayStats {
+  std::atomic<uint64_t> connected{0};
+  std::atomic<uint64_t> connect_failed{0};
+  std::atomic<uint64_t> sent{0};
+  std::atomic<uint64_t> received{0};
+  std::atomic<uint64_t> malformed{0};
+  std::atomic<uint64_t> error_acks{0};
+  std::atomic<uint64_t> unacked{0};
+  std::atomic<int> ready{0};    // connect finished, either way
+  std::atomic<int> running{0};  // connections with work left
+};
+
+//: one per io_context, merged for the report
+struct ReplayLatency {
+  LatencyHistogram ack_usec;       // scheduled send -> ack
+  LatencyHistogram send_lag_usec;  // scheduled send -> timer fired
+};
+
+int64_t ToMicros(const std::chrono::steady_clock::time_point& time_point) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             time_point.time_since_epoch())
+      .count();
+}
+
+int64_t GetMicrosNow() { return ToMicros(std::chrono::steady_clock::now()); }
+
+bool ReadVarint(std::istream& in, uint64_t* v) {
+  *v = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    const int c = in.get();
+    if (c == EOF) {
+      return false;
+    }
+    *v |= static_cast<uint64_t>(c & 0x7f) << shift;
+    if ((c & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool LoadCapture(const std::string& path,
+                 std::vector<CaptureConnection>* connections) {
+  std::ifstream in(path, std::ios::in | std::ios::binary);
+  char magic[sizeof(FILE_MAGIC) - 1] = {};
+  if (!in || !in.read(magic, sizeof(magic)) ||
+      !std::equal(std::begin(magic), std::end(magic), FILE_MAGIC)) {
+    std::cerr << "replay: " << path << " is not a capture file\n";
+    return false;
+  }
+
+  int64_t offset_usec = 0;
+  while (true) {
+    const int kind = in.get();
+    if (kind == EOF) {
+      return true;
+    }
+    uint64_t connection = 0;
+    uint64_t delta_usec = 0;
+    if ((kind != RECORD_FRAME && kind != RECORD_CLOSE) ||
+        !ReadVarint(in, &connection) || !ReadVarint(in, &delta_usec)) {
+      break;
+    }
+    offset_usec += static_cast<int64_t>(delta_usec);
+
+    CaptureRecord record{offset_usec, kind == RECORD_CLOSE, 0, ""};
+    if (kind == RECORD_FRAME) {
+      uint64_t length = 0;
+      if (!ReadVarint(in, &length) ||
+          length > SimpleMessage::max_body_length) {
+        break;
+      }
+      record.body.resize(static_cast<size_t>(length));
+      if (!in.read(&record.body[0], record.body.size())) {
+        break;
+      }
+      MessageEnvelope envelope;
+      if (Envelope::Parse(record.body.data(), record.body.size(),
+                          [](const int) { return true; },
+                          &envelope) == Envelope::Result::OK) {
+        record.msg_type = envelope.msg_type;
+      }
+    }
+    if (connection >= connections->size()) {
+      connections->resize(static_cast<size_t>(connection) + 1);
+    }
+    (*connections)[static_cast<size_t>(connection)].emplace_back(
+        std::move(record));
+  }
+  std::cerr << "replay: " << path << " is truncated\n";
+  return false;
+}
+
+bool IsRequest(const int msg_type) {
+  switch (static_cast<MessageType>(msg_type)) {
+    case MessageType::Hello:
+    case MessageType::Register:
+    case MessageType::EnterRoom:
+    case MessageType::ExitRoom:
+    case MessageType::SendChat:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsAck(const int msg_type) {
+  switch (static_cast<MessageType>(msg_type)) {
+    case MessageType::HelloAck:
+    case MessageType::RegisterAck:
+    case MessageType::EnterRoomAck:
+    case MessageType::ExitRoomAck:
+    case MessageType::SendChatAck:
+      return true;
+    default:
+      return false;
+  }
+}
+
+//: an ack body that doesn't decode counts as an error
+template <typename T>
+int GetResult(const MessageEnvelope& envelope) {
+  T ack;
+  return MessageBody(envelope).Decode(&ack) ? ack.result : 0;
+}
+
+int GetAckResult(const MessageEnvelope& envelope) {
+  switch (static_cast<MessageType>(envelope.msg_type)) {
+    case MessageType::HelloAck:
+      return GetResult<Protocol::HelloAck>(envelope);
+    case MessageType::RegisterAck:
+      return GetResult<Protocol::RegisterAck>(envelope);
+    case MessageType::EnterRoomAck:
+      return GetResult<Protocol::EnterRoomAck>(envelope);
+    case MessageType::ExitRoomAck:
+      return GetResult<Protocol::ExitRoomAck>(envelope);
+    case MessageType::SendChatAck:
+      return GetResult<Protocol::SendChatAck>(envelope);
+    default:
+      return 0;
+  }
+}
+
+void PrintLatencyRow(const char* name, const LatencyHistogram& histogram) {
+  std::printf("%-9s %10" PRIu64 " %8" PRId64 " %8" PRId64 " %8" PRId64
+              " %8" PRId64 " %8" PRId64 "\n",
+              name, histogram.Count(), histogram.Percentile(50),
+              histogram.Percentile(90), histogram.Percentile(99),
+              histogram.Percentile(99.9), histogram.Max());
+}
+
+//:
+//: one captured connection, only touched from its io_context thread
+//:
+class ReplayConnection : public std::enable_shared_from_this<ReplayConnection> {
+ public:
+  ReplayConnection(boost::asio::io_context& io_context,
+                   const CaptureConnection& records, const double speed,
+                   ReplayStats* stats, ReplayLatency* latency)
+      : records_(records),
+        speed_(speed),
+        stats_(stats),
+        latency_(latency),
+        socket_(io_context),
+        timer_(io_context),
+        next_record_(0),
+        is_connected_(false),
+        is_closing_(false),
+        is_running_(false) {}
+
+  void Connect(const tcp::endpoint& endpoint) {
+    auto self(shared_from_this());
+    socket_.async_connect(endpoint,
+                          [this, self](boost::system::error_code ec) {
+                            if (ec) {
+                              ++stats_->connect_failed;
+                            } else {
+                              is_connected_ = true;
+                              ++stats_->connected;
+                              ReadHeader();
+                            }
+                            ++stats_->ready;
+                          });
+  }
+
+  void Start(const std::chrono::steady_clock::time_point& start) {
+    auto self(shared_from_this());
+    boost::asio::post(socket_.get_executor(), [this, self, start]() {
+      start_ = start;
+      is_running_ = true;
+      ++stats_->running;
+      if (!is_connected_) {
+        Finish();
+        return;
+      }
+      ScheduleNext();
+    });
+  }
+
+  void Stop() {
+    auto self(shared_from_this());
+    boost::asio::post(socket_.get_executor(), [this, self]() { Close(); });
+  }
+
+ private:
+  std::chrono::steady_clock::time_point GetScheduledTime(
+      const CaptureRecord& record) const {
+    if (speed_ <= 0) {
+      return start_;
+    }
+    return start_ + std::chrono::microseconds(static_cast<int64_t>(
+                        record.offset_usec / speed_));
+  }
+
+  void ScheduleNext() {
+    // everything already due goes out now, a late timer catches up
+    while (next_record_ < records_.size() && !is_closing_) {
+      const auto scheduled = GetScheduledTime(records_[next_record_]);
+      if (speed_ > 0 && scheduled > std::chrono::steady_clock::now()) {
+        auto self(shared_from_this());
+        timer_.expires_at(scheduled);
+        timer_.async_wait([this, self](boost::system::error_code ec) {
+          if (!ec && is_connected_) {
+            ScheduleNext();
+          }
+        });
+        return;
+      }
+      SendRecord(records_[next_record_++], scheduled);
+    }
+    CheckFinished();
+  }
+
+  void SendRecord(const CaptureRecord& record,
+                  const std::chrono::steady_clock::time_point& scheduled) {
+    if (record.is_close) {
+      // the session closed here in the capture, after its answers arrive
+      is_closing_ = true;
+      next_record_ = records_.size();
+      CloseIfDrained();
+      return;
+    }
+
+    const int64_t scheduled_usec = ToMicros(scheduled);
+    latency_->send_lag_usec.Record(GetMicrosNow() - scheduled_usec);
+    if (IsRequest(record.msg_type)) {
+      pending_acks_.push_back(scheduled_usec);
+    }
+
+    SimpleMessage msg;
+    msg.body_length(record.body.size());
+    std::memcpy(msg.body(), record.body.data(), msg.body_length());
+    msg.encode_header();
+    const bool write_in_progress = !write_msgs_.empty();
+    write_msgs_.push_back(msg);
+    if (!write_in_progress) {
+      Write();
+    }
+  }
+
+  void Write() {
+    auto self(shared_from_this());
+    boost::asio::async_write(
+        socket_,
+        boost::asio::buffer(write_msgs_.front().data(),
+                            write_msgs_.front().length()),
+        [this, self](boost::system::error_code ec, std::size_t /*length*/) {
+          if (ec) {
+            Close();
+            return;
+          }
+          ++stats_->sent;
+          write_msgs_.pop_front();
+          if (!write_msgs_.empty()) {
+            Write();
+          } else {
+            CloseIfDrained();
+          }
+        });
+  }
+
+  void ReadHeader() {
+    auto self(shared_from_this());
+    boost::asio::async_read(
+        socket_,
+        boost::asio::buffer(read_msg_.data(), SimpleMessage::header_length),
+        [this, self](boost::system::error_code ec, std::size_t /*length*/) {
+          if (!ec && read_msg_.decode_header()) {
+            ReadBody();
+          } else {
+            Close();
+          }
+        });
+  }
+
+  void ReadBody() {
+    auto self(shared_from_this());
+    boost::asio::async_read(
+        socket_, boost::asio::buffer(read_msg_.body(), read_msg_.body_length()),
+        [this, self](boost::system::error_code ec, std::size_t /*length*/) {
+          if (ec) {
+            Close();
+            return;
+          }
+          OnMessage();
+          ReadHeader();
+        });
+  }
+
+  void OnMessage() {
+    ++stats_->received;
+
+    MessageEnvelope envelope;
+    if (Envelope::Parse(read_msg_.body(), read_msg_.body_length(),
+                        [](const int) { return true; },
+                        &envelope) != Envelope::Result::OK) {
+      ++stats_->malformed;
+      return;
+    }
+    if (!IsAck(envelope.msg_type)) {
+      return;
+    }
+    if (GetAckResult(envelope) != static_cast<int>(ResultType::Sucess)) {
+      ++stats_->error_acks;
+    }
+    // the server answers one session in request order
+    if (!pending_acks_.empty()) {
+      latency_->ack_usec.Record(GetMicrosNow() - pending_acks_.front());
+      pending_acks_.pop_front();
+    }
+    CloseIfDrained();
+    CheckFinished();
+  }
+
+  void CloseIfDrained() {
+    if (is_closing_ && write_msgs_.empty() && pending_acks_.empty()) {
+      Close();
+    }
+  }
+
+  void CheckFinished() {
+    if (next_record_ >= records_.size() && pending_acks_.empty()) {
+      Finish();
+    }
+  }
+
+  void Finish() {
+    if (is_running_) {
+      is_running_ = false;
+      --stats_->running;
+    }
+  }
+
+  void Close() {
+    boost::system::error_code ec;
+    timer_.cancel();
+    is_connected_ = false;
+    stats_->unacked += pending_acks_.size();
+    pending_acks_.clear();
+    socket_.close(ec);
+    Finish();
+  }
+
+  const CaptureConnection& records_;
+  const double speed_;
+  ReplayStats* stats_;
+  ReplayLatency* latency_;
+
+  tcp::socket socket_;
+  boost::asio::steady_timer timer_;
+  std::chrono::steady_clock::time_point start_;
+  size_t next_record_;
+  bool is_connected_;
+  bool is_closing_;
+  bool is_running_;
+
+  SimpleMessage read_msg_;
+  std::deque<SimpleMessage> write_msgs_;
+  std::deque<int64_t> pending_acks_;  // scheduled send usec
+};
+
+}  // namespace
+
+int RunReplay(const LoadOptions& options) {
+  using WorkGuard =
+      boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+  std::vector<CaptureConnection> captured;
+  if (!LoadCapture(options.replay_path, &captured)) {
+    return 1;
+  }
+  int64_t last_offset_usec = 0;
+  uint64_t frame_count = 0;
+  for (const auto& records : captured) {
+    for (const auto& record : records) {
+      last_offset_usec = std::max(last_offset_usec, record.offset_usec);
+      frame_count += record.is_close ? 0 : 1;
+    }
+  }
+  std::printf("replay: %zu connections, %" PRIu64 " frames over %.1fs\n",
+              captured.size(), frame_count, last_offset_usec / 1e6);
+
+  ReplayStats stats;
+  std::vector<std::unique_ptr<boost::asio::io_context>> io_contexts;
+  std::vector<std::unique_ptr<WorkGuard>> work_guards;
+  std::vector<std::unique_ptr<ReplayLatency>> latencies;
+  for (int i = 0; i < options.io_threads; ++i) {
+    io_contexts.emplace_back(std::make_unique<boost::asio::io_context>(1));
+    work_guards.emplace_back(std::make_unique<WorkGuard>(
+        boost::asio::make_work_guard(*io_contexts.back())));
+    latencies.emplace_back(std::make_unique<ReplayLatency>());
+  }
+
+  tcp::endpoint endpoint;
+  try {
+    tcp::resolver resolver(*io_contexts.front());
+    endpoint = *resolver.resolve(tcp::v4(), options.host, options.port)
+                    .begin();
+  } catch (const std::exception& e) {
+    std::cerr << "resolve failed: " << e.what() << "\n";
+    return 1;
+  }
+
+  std::vector<std::shared_ptr<ReplayConnection>> connections;
+  connections.reserve(captured.size());
+  for (size_t i = 0; i < captured.size(); ++i) {
+    const size_t context_index = i % io_contexts.size();
+    connections.emplace_back(std::make_shared<ReplayConnection>(
+        *io_contexts[context_index], captured[i], options.replay_speed,
+        &stats, latencies[context_index].get()));
+    connections.back()->Connect(endpoint);
+  }
+
+  std::vector<std::unique_ptr<boost::thread>> threads;
+  for (auto& io_context : io_contexts) {
+    auto context = io_context.get();
+    threads.emplace_back(
+        std::make_unique<boost::thread>([context]() { context->run(); }));
+  }
+
+  // the whole capture starts once every connection is open, so connect
+  // time doesn't skew the recorded spacing
+  const auto connect_deadline = std::chrono::steady_clock::now() +
+                                std::chrono::seconds(CONNECT_TIMEOUT_SEC);
+  while (stats.ready.load() < static_cast<int>(captured.size()) &&
+         std::chrono::steady_clock::now() < connect_deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  const auto start = std::chrono::steady_clock::now() + START_DELAY;
+  for (auto& connection : connections) {
+    connection->Start(start);
+  }
+
+  const int64_t replay_usec =
+      options.replay_speed > 0
+          ? static_cast<int64_t>(last_offset_usec / options.replay_speed)
+          : 0;
+  const auto deadline = start + std::chrono::microseconds(replay_usec) +
+                        std::chrono::seconds(DRAIN_TIMEOUT_SEC);
+  std::this_thread::sleep_for(START_DELAY);
+  uint64_t last_sent = 0;
+  for (int tick = 1; stats.running.load() > 0 &&
+                     std::chrono::steady_clock::now() < deadline;
+       ++tick) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (tick % 10 != 0) {
+      continue;
+    }
+    const uint64_t sent = stats.sent.load();
+    std::printf("[%6.1fs] sent %" PRIu64 "/%" PRIu64 " (%" PRIu64
+                "/s) received %" PRIu64 ", %d connections busy\n",
+                (GetMicrosNow() - ToMicros(start)) / 1e6, sent, frame_count,
+                sent - last_sent, stats.received.load(),
+                stats.running.load());
+    last_sent = sent;
+  }
+  const double elapsed_sec =
+      std::max<int64_t>(1, GetMicrosNow() - ToMicros(start)) / 1e6;
+
+  for (auto& connection : connections) {
+    connection->Stop();
+  }
+  for (auto& work_guard : work_guards) {
+    work_guard->reset();
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  connections.clear();
+
+  ReplayLatency total;
+  for (const auto& latency : latencies) {
+    total.ack_usec.Merge(latency->ack_usec);
+    total.send_lag_usec.Merge(latency->send_lag_usec);
+  }
+
+  char speed[32] = "as fast as possible";
+  if (options.replay_speed > 0) {
+    std::snprintf(speed, sizeof(speed), "%gx", options.replay_speed);
+  }
+  std::printf(
+      "\n---- replay report ----\n"
+      "speed           : %s\n"
+      "duration        : %.1fs (captured %.1fs)\n"
+      "connected       : %" PRIu64 " (failed %" PRIu64 ")\n"
+      "frames sent     : %" PRIu64 " of %" PRIu64 " (%.0f/s)\n"
+      "frames received : %" PRIu64 " (%.0f/s, malformed %" PRIu64 ")\n"
+      "error acks      : %" PRIu64 "\n"
+      "unacked         : %" PRIu64 "\n",
+      speed, elapsed_sec, last_offset_usec / 1e6, stats.connected.load(),
+      stats.connect_failed.load(), stats.sent.load(), frame_count,
+      stats.sent.load() / elapsed_sec, stats.received.load(),
+      stats.received.load() / elapsed_sec, stats.malformed.load(),
+      stats.error_acks.load(), stats.unacked.load());
+
+  std::printf("\n---- latency from scheduled send (usec) ----\n");
+  std::printf("%-9s %10s %8s %8s %8s %8s %8s\n", "", "count", "p50", "p90",
+              "p99", "p99.9", "max");
+  PrintLatencyRow("ack", total.ack_usec);
+  PrintLatencyRow("send lag", total.send_lag_usec);
+  std::fflush(stdout);
+  return 0;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "load_generator.h"
+
+//:
+//: replays a server capture (capture_start on the server console)
+//: every captured connection gets its own socket, frames keep their
+//: recorded spacing divided by replay_speed
+//: latencies count from the scheduled send time like the load generator
+//:
+int RunReplay(const LoadOptions& options);
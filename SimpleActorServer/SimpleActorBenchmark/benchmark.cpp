@@ -0,0 +1,188 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include "utility.h"
+
+namespace {
+
+std::string name_filter;
+int repetition_count = 5;
+double operation_scale = 1.0;
+std::vector<Benchmark::Result> results;
+std::vector<std::pair<std::string, double>> next_counters;
+
+volatile uint64_t sink = 0;
+
+double RunOnce(const int threads, const uint64_t operations,
+               const Benchmark::Body& body,
+               const std::function<void()>& wait) {
+  std::atomic<int> ready{0};
+  std::atomic<bool> go{false};
+  std::vector<std::unique_ptr<std::thread>> workers;
+  workers.reserve(threads);
+
+  for (int i = 0; i < threads; ++i) {
+    uint64_t share = operations / threads;
+    if (static_cast<uint64_t>(i) < operations % threads) {
+      ++share;
+    }
+    workers.emplace_back(std::make_unique<std::thread>(
+        [i, share, &body, &ready, &go]() {
+          ++ready;
+          while (not go.load()) {
+            std::this_thread::yield();
+          }
+          body(i, share);
+        }));
+  }
+  while (ready.load() != threads) {
+    std::this_thread::yield();
+  }
+
+  const auto begin = std::chrono::steady_clock::now();
+  go.store(true);
+  for (auto& worker : workers) {
+    worker->join();
+  }
+  if (!!wait) {
+    wait();
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  return static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin)
+          .count());
+}
+
+std::string Escape(const std::string& v) {
+  std::string escaped;
+  for (const char c : v) {
+    if (c == '"' or c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+}  // namespace
+
+void Benchmark::SetFilter(const std::string& filter) { name_filter = filter; }
+
+void Benchmark::SetRepetitions(const int repetitions) {
+  repetition_count = std::max(1, repetitions);
+}
+
+void Benchmark::SetScale(const double scale) { operation_scale = scale; }
+
+void Benchmark::Run(const std::string& name, const int threads,
+                    const uint64_t operations, const Body& body,
+                    const std::function<void()>& wait) {
+  const std::string full_name =
+      name + "/threads:" + std::to_string(threads);
+  auto counters = std::move(next_counters);
+  next_counters.clear();
+  if (not name_filter.empty() and
+      full_name.find(name_filter) == std::string::npos) {
+    return;
+  }
+
+  const uint64_t scaled = std::max<uint64_t>(
+      static_cast<uint64_t>(threads),
+      static_cast<uint64_t>(static_cast<double>(operations) * operation_scale));
+
+  // warm up caches, allocators and lazily created singletons
+  RunOnce(threads, std::max<uint64_t>(threads, scaled / 10), body, wait);
+
+  std::vector<double> samples;
+  samples.reserve(repetition_count);
+  for (int i = 0; i < repetition_count; ++i) {
+    samples.emplace_back(RunOnce(threads, scaled, body, wait) / scaled);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  Result result;
+  result.name = full_name;
+  result.threads = threads;
+  result.operations = scaled;
+  result.repetitions = repetition_count;
+  result.median_nsec = samples[samples.size() / 2];
+  result.min_nsec = samples.front();
+  result.max_nsec = samples.back();
+  result.counters = std::move(counters);
+  results.emplace_back(result);
+
+  std::ostringstream line;
+  line << std::left << std::setw(56) << full_name << std::right
+       << std::setw(12) << std::fixed << std::setprecision(1)
+       << result.median_nsec << " ns/op";
+  for (const auto& counter : result.counters) {
+    line << "  " << counter.first << "=" << counter.second;
+  }
+  std::fprintf(stderr, "%s\n", line.str().c_str());
+}
+
+void Benchmark::SetCounter(const std::string& name, const double value) {
+  next_counters.emplace_back(name, value);
+}
+
+const std::vector<Benchmark::Result>& Benchmark::GetResults() {
+  return results;
+}
+
+std::string Benchmark::ToJson() {
+  // same layout as google benchmark --benchmark_format=json, so its
+  // tools/compare.py can diff two runs. only wall time is measured, it is
+  // reported as cpu_time too
+  const std::time_t now = std::time(nullptr);
+  char date[32] = "";
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  out << "{\n  \"context\": {\n"
+      << "    \"date\": \"" << date << "\",\n"
+      << "    \"executable\": \"SimpleActorBenchmark\",\n"
+      << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+      << "    \"library_build_type\": \"release\",\n"
+#else
+      << "    \"library_build_type\": \"debug\",\n"
+#endif
+      << "    \"repetitions\": " << repetition_count << "\n  },\n"
+      << "  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& result = results[i];
+    out << (i == 0 ? "\n" : ",\n") << "    {\n"
+        << "      \"name\": \"" << Escape(result.name) << "\",\n"
+        << "      \"run_name\": \"" << Escape(result.name) << "\",\n"
+        << "      \"run_type\": \"iteration\",\n"
+        << "      \"threads\": " << result.threads << ",\n"
+        << "      \"iterations\": " << result.operations << ",\n"
+        << "      \"real_time\": " << result.median_nsec << ",\n"
+        << "      \"cpu_time\": " << result.median_nsec << ",\n"
+        << "      \"min_time\": " << result.min_nsec << ",\n"
+        << "      \"max_time\": " << result.max_nsec << ",\n"
+        << "      \"time_unit\": \"ns\",\n";
+    for (const auto& counter : result.counters) {
+      out << "      \"" << Escape(counter.first) << "\": " << counter.second
+          << ",\n";
+    }
+    out << "      \"items_per_second\": "
+        << (result.median_nsec > 0 ? 1e9 / result.median_nsec : 0) << "\n"
+        << "    }";
+  }
+  out << "\n  ]\n}\n";
+  return out.str();
+}
+
+void Benchmark::Consume(const uint64_t v) { sink = sink + v; }
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+//:
+//: self-contained benchmark harness
+//: each case runs `operations` iterations split over `threads` threads,
+//: repeated and reported as the median ns per operation
+//:
+namespace Benchmark {
+
+struct Result {
+  std::string name;
+  int threads;
+  uint64_t operations;
+  int repetitions;
+  double median_nsec;
+  double min_nsec;
+  double max_nsec;
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+//: body(thread_index, operations of that thread)
+using Body = std::function<void(const int, const uint64_t)>;
+
+void SetFilter(const std::string& filter);
+void SetRepetitions(const int repetitions);
+void SetScale(const double scale);
+
+//: wait runs inside the timed region after every thread joined, for cases
+//: whose work completes asynchronously (actor mailbox, timer)
+void Run(const std::string& name, const int threads, const uint64_t operations,
+         const Body& body, const std::function<void()>& wait = nullptr);
+
+//: reported with the next Run, like a google benchmark user counter
+void SetCounter(const std::string& name, const double value);
+
+const std::vector<Result>& GetResults();
+std::string ToJson();
+
+//: keeps a computed value alive so the compiler can't drop the loop
+void Consume(const uint64_t v);
+
+}  // namespace Benchmark
@@ -0,0 +1,792 @@
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/smart_ptr/detail/spinlock.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <concurrent_queue.h>
+#endif
+
+#include "actor_base_model.h"
+#include "benchmark.h"
+#include "clock.h"
+#include "concurrent_queue.h"
+#include "json.h"
+#include "logger.h"
+#include "member_table.h"
+#include "message_envelope.h"
+#include "messages.h"
+#include "response_frame.h"
+#include "room_manager.h"
+#include "session.h"
+#include "simple_message.h"
+#include "thread_pool_manager.h"
+#include "timer_event_manager.h"
+#include "user_manager.h"
+#include "utility.h"
+
+namespace {
+
+const int THREAD_COUNTS[] = {1, 2, 4, 8, 16, 32, 64};
+const int REGISTRY_USER_COUNT = 10000;
+const int REGISTRY_ROOM_COUNT = 1000;
+const int AFFINITY_ACTOR_COUNT = 256;
+const uint64_t AFFINITY_PROBE_COUNT = 1 << 16;
+const size_t ROOM_SIZES[] = {16, 256, 4096, 20000};
+// member frames per case, few enough that no session queue reaches
+// SESSION_OUTBOUND_LIMIT_BYTES over the default repetitions
+const uint64_t ROOM_SENDS = 1 << 12;
+
+class BenchActor : public ActorBaseModel {
+ protected:
+  void SendAsyncEvent(const int, const std::shared_ptr<IEventData>&) override {}
+};
+
+void WaitFor(const std::atomic<uint64_t>& counter, const uint64_t expected) {
+  while (counter.load() < expected) {
+    std::this_thread::yield();
+  }
+}
+
+#pragma region ConcurrentQueue
+//: baseline for ConcurrentQueue, what a portable queue costs without it
+template <typename T>
+class MutexQueue {
+ public:
+  void Enqueue(const T& value) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    queue_.push_back(value);
+  }
+  bool TryDequeue(T* value) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (queue_.empty()) {
+      return false;
+    }
+    *value = queue_.front();
+    queue_.pop_front();
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::deque<T> queue_;
+};
+
+#ifdef _MSC_VER
+//: the PPL queue ConcurrentQueue used to wrap
+template <typename T>
+class PplQueue {
+ public:
+  void Enqueue(const T& value) { queue_.push(value); }
+  bool TryDequeue(T* value) { return queue_.try_pop(*value); }
+
+ private:
+  concurrency::concurrent_queue<T> queue_;
+};
+#endif
+
+template <typename Queue>
+void RunQueue(const std::string& name) {
+  for (const int threads : THREAD_COUNTS) {
+    Queue queue;
+    Benchmark::Run(name + "/EnqueueDequeue", threads, 1 << 20,
+                   [&queue](const int, const uint64_t operations) {
+                     uint64_t v = 0;
+                     for (uint64_t i = 0; i < operations; ++i) {
+                       queue.Enqueue(i);
+                       queue.TryDequeue(&v);
+                     }
+                     Benchmark::Consume(v);
+                   });
+  }
+
+  // even threads produce, odd threads consume what the one before produced
+  for (const int threads : THREAD_COUNTS) {
+    if (threads < 2) {
+      continue;
+    }
+    Queue queue;
+    Benchmark::Run(name + "/ProducerConsumer", threads, 1 << 20,
+                   [&queue](const int index, const uint64_t operations) {
+                     if (index % 2 == 0) {
+                       for (uint64_t i = 0; i < operations; ++i) {
+                         queue.Enqueue(i);
+                       }
+                       return;
+                     }
+                     uint64_t v = 0;
+                     for (uint64_t i = 0; i < operations;) {
+                       if (queue.TryDequeue(&v)) {
+                         ++i;
+                       } else {
+                         std::this_thread::yield();
+                       }
+                     }
+                     Benchmark::Consume(v);
+                   });
+  }
+}
+
+void RunConcurrentQueue() {
+  RunQueue<ConcurrentQueue<uint64_t>>("ConcurrentQueue");
+  RunQueue<MutexQueue<uint64_t>>("MutexQueue");
+#ifdef _MSC_VER
+  RunQueue<PplQueue<uint64_t>>("PplQueue");
+#endif
+}
+#pragma endregion
+
+#pragma region Actor
+struct PingPongState {
+  std::atomic<uint64_t> remaining;
+  std::atomic<uint64_t> done;
+};
+
+void Bounce(const std::shared_ptr<BenchActor>& from,
+            const std::shared_ptr<BenchActor>& to,
+            const std::shared_ptr<PingPongState>& state) {
+  to->AsyncTask([from, to, state]() {
+    if (--state->remaining == 0) {
+      state->done.store(1);
+      return;
+    }
+    Bounce(to, from, state);
+  });
+}
+
+void RunActor() {
+  auto ping = std::make_shared<BenchActor>();
+  auto pong = std::make_shared<BenchActor>();
+  auto state = std::make_shared<PingPongState>();
+  Benchmark::Run(
+      "Actor/AsyncTask/PingPong", 1, 1 << 18,
+      [ping, pong, state](const int, const uint64_t operations) {
+        state->done.store(0);
+        state->remaining.store(operations);
+        Bounce(ping, pong, state);
+      },
+      [state]() { WaitFor(state->done, 1); });
+
+  for (const int threads : THREAD_COUNTS) {
+    auto sink = std::make_shared<BenchActor>();
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> sent{0};
+    Benchmark::Run(
+        "Actor/AsyncTask/FanIn", threads, 1 << 18,
+        [&sink, &received, &sent](const int, const uint64_t operations) {
+          for (uint64_t i = 0; i < operations; ++i) {
+            sink->AsyncTask([&received]() { ++received; });
+          }
+          sent += operations;
+        },
+        [&received, &sent]() { WaitFor(received, sent.load()); });
+  }
+
+  // many actors each getting a message at a time, the way sessions do
+  auto pool = ThreadPoolManager::GetInstance();
+  std::vector<std::shared_ptr<BenchActor>> actors;
+  for (int i = 0; i < AFFINITY_ACTOR_COUNT; ++i) {
+    actors.emplace_back(std::make_shared<BenchActor>());
+  }
+  for (const bool is_affinity : {false, true}) {
+    pool->SetAffinity(is_affinity);
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> sent{0};
+
+    // counters go with the next run, so an untimed pass measures placement
+    const ActivationStatus before = pool->GetActivationStatus();
+    for (uint64_t i = 0; i < AFFINITY_PROBE_COUNT; ++i) {
+      actors[i % actors.size()]->AsyncTask([&received]() { ++received; });
+    }
+    WaitFor(received, AFFINITY_PROBE_COUNT);
+    received.store(0);
+    const ActivationStatus after = pool->GetActivationStatus();
+    const uint64_t local = after.local - before.local;
+    const uint64_t total = local + after.migrated - before.migrated;
+    Benchmark::SetCounter("local_ratio",
+                          total == 0 ? 0.0 : local / (double)total);
+
+    Benchmark::Run(
+        is_affinity ? "Actor/AsyncTask/ManyActors/Affinity"
+                    : "Actor/AsyncTask/ManyActors/Shared",
+        4, 1 << 17,
+        [&actors, &received, &sent](const int thread,
+                                    const uint64_t operations) {
+          for (uint64_t i = 0; i < operations; ++i) {
+            actors[(thread + i) % actors.size()]->AsyncTask(
+                [&received]() { ++received; });
+          }
+          sent += operations;
+        },
+        [&received, &sent]() { WaitFor(received, sent.load()); });
+  }
+  pool->SetAffinity(THREAD_POOL_AFFINITY);
+}
+#pragma endregion
+
+#pragma region Timer
+void RunTimer() {
+  for (const int threads : {1, 4, 16}) {
+    auto actor = std::make_shared<BenchActor>();
+    std::atomic<uint64_t> fired{0};
+    std::atomic<uint64_t> invoked{0};
+    Benchmark::Run(
+        "Timer/InvokeEvent/InsertFire", threads, 1 << 17,
+        [&actor, &fired, &invoked](const int, const uint64_t operations) {
+          auto manager = TimerEventManager::GetInstance();
+          for (uint64_t i = 0; i < operations; ++i) {
+            manager->InvokeEvent(actor, [&fired]() { ++fired; }, 0);
+          }
+          invoked += operations;
+        },
+        [&fired, &invoked]() { WaitFor(fired, invoked.load()); });
+  }
+}
+#pragma endregion
+
+#pragma region Clock
+void RunClock() {
+  Benchmark::Run("Clock/GetMillis", 1, 1 << 22,
+                 [](const int, const uint64_t operations) {
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     total += Clock::GetMillis();
+                   }
+                   Benchmark::Consume(total);
+                 });
+
+  Clock::Start();
+  Benchmark::Run("Clock/GetWallMillis", 1, 1 << 22,
+                 [](const int, const uint64_t operations) {
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     total += Clock::GetWallMillis();
+                   }
+                   Benchmark::Consume(total);
+                 });
+  Clock::Stop();
+
+  // what the timers and the thread pool used to read twice per task
+  Benchmark::Run(
+      "Clock/PosixLocalTime", 1, 1 << 20,
+      [](const int, const uint64_t operations) {
+        uint64_t total = 0;
+        for (uint64_t i = 0; i < operations; ++i) {
+          const boost::posix_time::ptime epoch(
+              boost::gregorian::date(1970, 1, 1));
+          total += (boost::posix_time::microsec_clock::local_time() - epoch)
+                       .total_milliseconds();
+        }
+        Benchmark::Consume(total);
+      });
+}
+#pragma endregion
+
+#pragma region Message
+Json MakeChatBody() {
+  Json body;
+  body.SetObject();
+  body.SetAttribute("result", 1);
+  body.SetAttribute("sender", std::string("benchmark"));
+  body.SetAttribute("chat_message", std::string("hello, simple actor server"));
+  return body;
+}
+
+void RunMessage() {
+  const Json body = MakeChatBody();
+  Benchmark::Run("Message/MakeMessage", 1, 1 << 17,
+                 [&body](const int, const uint64_t operations) {
+                   uint64_t length = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     length += SimpleMessage::MakeMessage(
+                                   static_cast<int>(
+                                       MessageType::BroadcastingChat),
+                                   body)
+                                   .length();
+                   }
+                   Benchmark::Consume(length);
+                 });
+
+  Protocol::BroadcastingChat chat;
+  chat.result = 1;
+  chat.sender = "benchmark";
+  chat.chat_message = "hello, simple actor server";
+  Benchmark::Run("Message/MakeMessage/Typed", 1, 1 << 17,
+                 [&chat](const int, const uint64_t operations) {
+                   uint64_t length = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     length += SimpleMessage::MakeMessage(chat).length();
+                   }
+                   Benchmark::Consume(length);
+                 });
+
+  char json[SimpleMessage::max_body_length];
+  const std::size_t json_length = chat.EncodeJson(json, sizeof(json));
+  Benchmark::Run("Message/DecodeJson/Typed", 1, 1 << 20,
+                 [&json, json_length](const int, const uint64_t operations) {
+                   Protocol::BroadcastingChat decoded;
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     decoded.DecodeJson(json, json_length);
+                     total += decoded.chat_message.size();
+                   }
+                   Benchmark::Consume(total);
+                 });
+
+  char binary[SimpleMessage::max_body_length];
+  Benchmark::Run("Message/EncodeBinary/Typed", 1, 1 << 20,
+                 [&chat, &binary](const int, const uint64_t operations) {
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     total += chat.EncodeBinary(binary, sizeof(binary));
+                   }
+                   Benchmark::Consume(total);
+                 });
+
+  const std::size_t binary_length = chat.EncodeBinary(binary, sizeof(binary));
+  Benchmark::Run("Message/DecodeBinary/Typed", 1, 1 << 20,
+                 [&binary, binary_length](const int,
+                                          const uint64_t operations) {
+                   Protocol::BroadcastingChat decoded;
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     decoded.DecodeBinary(binary, binary_length);
+                     total += decoded.chat_message.size();
+                   }
+                   Benchmark::Consume(total);
+                 });
+
+  // what a session queues per ack, a fresh frame or the shared one
+  Protocol::SendChatAck ack;
+  ack.result = static_cast<int>(ResultType::Sucess);
+  Benchmark::Run("Message/Ack/Encoded", 1, 1 << 20,
+                 [&ack](const int, const uint64_t operations) {
+                   uint64_t length = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     auto frame = std::make_shared<const SimpleMessage>(
+                         SimpleMessage::MakeMessage(ack));
+                     length += frame->length();
+                   }
+                   Benchmark::Consume(length);
+                 });
+
+  ResponseFrame::Initialize();
+  Benchmark::Run("Message/Ack/PreEncoded", 1, 1 << 20,
+                 [](const int, const uint64_t operations) {
+                   uint64_t length = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     auto frame = ResponseFrame::Get(MessageType::SendChatAck,
+                                                     ResultType::Sucess,
+                                                     Codec::JSON);
+                     length += frame->length();
+                   }
+                   Benchmark::Consume(length);
+                 });
+
+  const SimpleMessage encoded = SimpleMessage::MakeMessage(
+      static_cast<int>(MessageType::BroadcastingChat), body);
+  Benchmark::Run("Message/DecodeHeader", 1, 1 << 22,
+                 [&encoded](const int, const uint64_t operations) {
+                   SimpleMessage msg = encoded;
+                   uint64_t length = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     msg.decode_header();
+                     length += msg.body_length();
+                   }
+                   Benchmark::Consume(length);
+                 });
+}
+#pragma endregion
+
+#pragma region Codec
+//: whole frames the way a session writes and reads them, in both codecs
+template <typename T>
+void RunCodecCase(const std::string& name, const T& msg) {
+  const struct {
+    const char* name;
+    Codec codec;
+  } codecs[] = {{"Json", Codec::JSON}, {"Binary", Codec::BINARY}};
+
+  for (const auto& codec : codecs) {
+    const std::string prefix = "Codec/" + name + "/" + codec.name;
+    const SimpleMessage frame = SimpleMessage::MakeMessage(msg, codec.codec);
+
+    Benchmark::SetCounter("bytes", static_cast<double>(frame.length()));
+    Benchmark::Run(prefix + "/Encode", 1, 1 << 20,
+                   [&msg, &codec](const int, const uint64_t operations) {
+                     uint64_t length = 0;
+                     for (uint64_t i = 0; i < operations; ++i) {
+                       length +=
+                           SimpleMessage::MakeMessage(msg, codec.codec)
+                               .length();
+                     }
+                     Benchmark::Consume(length);
+                   });
+
+    Benchmark::SetCounter("bytes", static_cast<double>(frame.length()));
+    Benchmark::Run(
+        prefix + "/Decode", 1, 1 << 20,
+        [&frame](const int, const uint64_t operations) {
+          const std::function<bool(const int)> accept = [](const int) {
+            return true;
+          };
+          T decoded;
+          uint64_t decoded_count = 0;
+          for (uint64_t i = 0; i < operations; ++i) {
+            MessageEnvelope envelope;
+            if (Envelope::Parse(frame.body(), frame.body_length(), accept,
+                                &envelope) == Envelope::Result::OK and
+                MessageBody(envelope).Decode(&decoded)) {
+              ++decoded_count;
+            }
+          }
+          Benchmark::Consume(decoded_count);
+        });
+  }
+}
+
+void RunCodec() {
+  Protocol::SendChatAck ack;
+  ack.result = static_cast<int>(ResultType::Sucess);
+  RunCodecCase("SendChatAck", ack);
+
+  Protocol::BroadcastingChat chat;
+  chat.result = static_cast<int>(ResultType::Sucess);
+  chat.sender = "benchmark";
+  chat.chat_message = "hello, simple actor server";
+  RunCodecCase("BroadcastingChat", chat);
+}
+#pragma endregion
+
+#pragma region Json
+void RunJson() {
+  const Json doc = MakeChatBody();
+  Benchmark::Run("Json/GetAttribute/Int", 1, 1 << 20,
+                 [&doc](const int, const uint64_t operations) {
+                   int result = 0;
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     doc.GetAttribute("result", &result);
+                     total += result;
+                   }
+                   Benchmark::Consume(total);
+                 });
+  Benchmark::Run("Json/GetAttribute/String", 1, 1 << 20,
+                 [&doc](const int, const uint64_t operations) {
+                   std::string message;
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     doc.GetAttribute("chat_message", &message);
+                     total += message.size();
+                   }
+                   Benchmark::Consume(total);
+                 });
+
+  Json envelope;
+  envelope.SetObject();
+  envelope.SetAttribute("msg_type", static_cast<int>(MessageType::SendChat));
+  envelope.SetAttribute("msg_body", doc);
+  Benchmark::Run("Json/GetAttribute/Object", 1, 1 << 17,
+                 [&envelope](const int, const uint64_t operations) {
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     JsonArena::Scope json_scope;
+                     Json body;
+                     envelope.GetAttribute("msg_body", &body);
+                     total += body.MemberCount();
+                   }
+                   Benchmark::Consume(total);
+                 });
+
+  const std::string frame = envelope.ToString();
+  Benchmark::Run("Json/Parse", 1, 1 << 17,
+                 [&frame](const int, const uint64_t operations) {
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     JsonArena::Scope json_scope;
+                     Json msg{frame};
+                     total += msg.MemberCount();
+                   }
+                   Benchmark::Consume(total);
+                 });
+
+  Benchmark::Run("Json/Envelope", 1, 1 << 20,
+                 [&frame](const int, const uint64_t operations) {
+                   const auto accept = [](const int) { return true; };
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     MessageEnvelope envelope;
+                     if (Envelope::Parse(frame.data(), frame.size(), accept,
+                                         &envelope) == Envelope::Result::OK) {
+                       total += envelope.body_length;
+                     }
+                   }
+                   Benchmark::Consume(total);
+                 });
+
+  Benchmark::Run("Json/SetAttribute", 1, 1 << 17,
+                 [](const int, const uint64_t operations) {
+                   uint64_t total = 0;
+                   for (uint64_t i = 0; i < operations; ++i) {
+                     JsonArena::Scope json_scope;
+                     total += MakeChatBody().MemberCount();
+                   }
+                   Benchmark::Consume(total);
+                 });
+}
+#pragma endregion
+
+#pragma region Registry
+void RunRegistry() {
+  std::vector<std::string> session_ids;
+  session_ids.reserve(REGISTRY_USER_COUNT);
+  for (int i = 0; i < REGISTRY_USER_COUNT; ++i) {
+    session_ids.emplace_back(Utility::GenerateStringUuid());
+    UserManager::CreateUser(session_ids.back());
+  }
+  std::vector<std::string> room_ids;
+  room_ids.reserve(REGISTRY_ROOM_COUNT);
+  for (int i = 0; i < REGISTRY_ROOM_COUNT; ++i) {
+    room_ids.emplace_back(RoomManager::CreateRoom()->GetRoomId());
+  }
+
+  for (const int threads : THREAD_COUNTS) {
+    Benchmark::Run("Registry/UserManager::GetUser", threads, 1 << 20,
+                   [&session_ids](const int index, const uint64_t operations) {
+                     uint64_t found = 0;
+                     for (uint64_t i = 0; i < operations; ++i) {
+                       const auto& id =
+                           session_ids[(i * 7919 + index) % session_ids.size()];
+                       found += !!UserManager::GetUser(id) ? 1 : 0;
+                     }
+                     Benchmark::Consume(found);
+                   });
+    Benchmark::Run("Registry/RoomManager::GetRoom", threads, 1 << 20,
+                   [&room_ids](const int index, const uint64_t operations) {
+                     uint64_t found = 0;
+                     for (uint64_t i = 0; i < operations; ++i) {
+                       const auto& id =
+                           room_ids[(i * 7919 + index) % room_ids.size()];
+                       found += !!RoomManager::GetRoom(id) ? 1 : 0;
+                     }
+                     Benchmark::Consume(found);
+                   });
+    // an EnterRoom and its ExitRoom, the seat goes back right away
+    Benchmark::Run("Registry/RoomManager::MatchRoom", threads, 1 << 20,
+                   [](const int, const uint64_t operations) {
+                     uint64_t total = 0;
+                     for (uint64_t i = 0; i < operations; ++i) {
+                       auto room = RoomManager::MatchRoom();
+                       RoomManager::LeaveRoom(room->GetRoomId());
+                       total += room->GetMemberCount();
+                     }
+                     Benchmark::Consume(total);
+                   });
+  }
+
+  for (const auto& id : session_ids) {
+    UserManager::EraseUser(id);
+  }
+  for (const auto& id : room_ids) {
+    RoomManager::EraseRoom(id);
+  }
+}
+#pragma endregion
+
+#pragma region Room
+//: stands in for Connection's session table, the same map under a spinlock
+class SessionTable {
+ public:
+  void Add(const std::shared_ptr<Session>& session) {
+    boost::lock_guard<boost::detail::spinlock> lock{lock_};
+    sessions_.emplace(session->GetSessionId(), session);
+  }
+  std::shared_ptr<Session> Get(const std::string& session_id) {
+    boost::lock_guard<boost::detail::spinlock> lock{lock_};
+    const auto it = sessions_.find(session_id);
+    return (it == sessions_.end()) ? nullptr : it->second;
+  }
+  void Clear() {
+    boost::lock_guard<boost::detail::spinlock> lock{lock_};
+    sessions_.clear();
+  }
+
+ private:
+  boost::detail::spinlock lock_ = BOOST_DETAIL_SPINLOCK_INIT;
+  std::unordered_map<std::string, std::shared_ptr<Session>> sessions_;
+};
+
+//:
+//: the path rooms broadcast through before they wrote to the sessions
+//: themselves: an event per member into its user actor, which looked its
+//: session up and encoded the chat for it
+//:
+class MemberActor : public ActorBaseModel {
+ public:
+  struct ChatEvent : IEventData {
+    Protocol::BroadcastingChat chat;
+  };
+
+  MemberActor(const std::string& session_id, SessionTable* sessions,
+              std::atomic<uint64_t>* sent)
+      : ActorBaseModel(std::hash<std::string>()(session_id)),
+        session_id_(session_id),
+        sessions_(sessions),
+        sent_(sent) {}
+
+  void SendAsyncEvent(const int,
+                      const std::shared_ptr<IEventData>& data) override {
+    auto event = std::dynamic_pointer_cast<ChatEvent>(data);
+    auto self(shared_from_this());
+    AsyncTask(
+        [this, self, event]() {
+          auto session = sessions_->Get(session_id_);
+          if (!!session) {
+            session->SendBroadcast(
+                std::make_shared<const SimpleMessage>(
+                    SimpleMessage::MakeMessage(event->chat,
+                                               session->GetCodec())),
+                event->chat.sender);
+          }
+          ++*sent_;
+        },
+        MailboxLane::BULK);
+  }
+
+ private:
+  const std::string session_id_;
+  SessionTable* const sessions_;
+  std::atomic<uint64_t>* const sent_;
+};
+
+//:
+//: one chat from a sender outside the room until every member's frame is
+//: queued on its session: the old map of member actors against the
+//: table. the sessions sit on unconnected sockets whose io_context only
+//: runs at the end, so nothing is written and every frame stays queued
+//: members join in a scattered order like a room that filled over time
+//:
+void RunRoom() {
+  const std::string sender = "sender";
+  const std::string chat_message = "see you all in the next round";
+  for (const size_t size : ROOM_SIZES) {
+    boost::asio::io_context io_context;
+    SessionTable session_table;
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> expected{0};
+    std::unordered_map<std::string, std::weak_ptr<MemberActor>> map;
+    std::vector<std::shared_ptr<MemberActor>> members;
+    MemberTable table;
+    std::vector<std::shared_ptr<Session>> sessions;
+    for (size_t i = 0; i < size * 2; ++i) {
+      sessions.emplace_back(std::make_shared<Session>(
+          boost::asio::ip::tcp::socket(io_context)));
+    }
+    for (size_t i = 0; i < size; ++i) {
+      // each case gets its own sessions, so their queues are alike
+      const auto& mailbox_session = sessions[(i * 7919) % size];
+      const auto& table_session = sessions[size + (i * 7919) % size];
+      const std::string& id = mailbox_session->GetSessionId();
+      session_table.Add(mailbox_session);
+      members.emplace_back(
+          std::make_shared<MemberActor>(id, &session_table, &sent));
+      map.emplace(id, members.back());
+      table.Add(table_session->GetSessionId(), "member", table_session);
+    }
+
+    const uint64_t broadcasts = std::max<uint64_t>(ROOM_SENDS / size, 1);
+    Benchmark::SetCounter("members", static_cast<double>(size));
+    Benchmark::Run(
+        "Room/Broadcast/Mailbox/" + std::to_string(size), 1, broadcasts,
+        [&](const int, const uint64_t operations) {
+          for (uint64_t i = 0; i < operations; ++i) {
+            for (const auto& entry : map) {
+              auto member = entry.second.lock();
+              if (!member) {
+                continue;
+              }
+              auto data = std::make_shared<MemberActor::ChatEvent>();
+              data->chat.result = static_cast<int>(ResultType::Sucess);
+              data->chat.sender = sender;
+              data->chat.chat_message = chat_message;
+              member->SendAsyncEvent(0, data);
+            }
+          }
+          expected += operations * map.size();
+        },
+        [&sent, &expected]() { WaitFor(sent, expected.load()); });
+    Benchmark::SetCounter("members", static_cast<double>(size));
+    Benchmark::Run("Room/Broadcast/Table/" + std::to_string(size), 1,
+                   broadcasts, [&](const int, const uint64_t operations) {
+                     for (uint64_t i = 0; i < operations; ++i) {
+                       table.SendChat(sender, chat_message);
+                     }
+                   });
+
+    // the queued writes fail on the closed sockets and let go of them
+    session_table.Clear();
+    sessions.clear();
+    io_context.run();
+  }
+}
+#pragma endregion
+
+void PrintUsage() {
+  std::cerr << "usage: SimpleActorBenchmark [--filter=<substring>] "
+               "[--repetitions=<n>] [--scale=<factor>] [--out=<path>]\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Log::SetLogLevel(Log::Level::WARNING);
+
+  std::string out_path;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.compare(0, 9, "--filter=") == 0) {
+      Benchmark::SetFilter(arg.substr(9));
+    } else if (arg.compare(0, 14, "--repetitions=") == 0) {
+      Benchmark::SetRepetitions(std::stoi(arg.substr(14)));
+    } else if (arg.compare(0, 8, "--scale=") == 0) {
+      Benchmark::SetScale(std::stod(arg.substr(8)));
+    } else if (arg.compare(0, 6, "--out=") == 0) {
+      out_path = arg.substr(6);
+    } else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  RunConcurrentQueue();
+  RunActor();
+  RunTimer();
+  RunClock();
+  RunMessage();
+  RunCodec();
+  RunJson();
+  RunRegistry();
+  RunRoom();
+
+  const std::string json = Benchmark::ToJson();
+  if (out_path.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream out(out_path, std::ios::out | std::ios::trunc);
+    out << json;
+  }
+
+  ThreadPoolManager::GetInstance()->Stop();
+  return 0;
+}
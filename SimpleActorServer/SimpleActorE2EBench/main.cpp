@@ -0,0 +1,311 @@
+#include <boost/chrono/process_cpu_clocks.hpp>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "load_generator.h"
+#include "logger.h"
+#include "network_manager.h"
+#include "network_utility.h"
+#include "room_manager.h"
+#include "server.h"
+
+// after asio, which brings in Windows.h in the right order
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+const int DRAIN_TIMEOUT_MSEC = 10000;
+
+//:
+//: one fixed load shape, connection counts are multiplied by --scale
+//:
+struct Scenario {
+  const char* name;
+  int rooms;
+  int connections;
+  double connect_per_sec;
+  double chat_per_sec;
+  int burst_size;
+};
+
+const Scenario SCENARIOS[] = {
+    {"big_room_steady", 1, 200, 1000.0, 2.0, 1},
+    {"small_rooms_steady", 20, 200, 1000.0, 2.0, 1},
+    {"big_room_burst", 1, 200, 1000.0, 0.25, 8},
+    {"connection_storm", 1, 1000, 100000.0, 0.2, 1},
+};
+
+struct ScenarioResult {
+  const Scenario* scenario;
+  int connections;
+  LoadSummary load;
+  double server_cpu_sec;
+  int64_t peak_rss_kb;
+  size_t rooms_used;
+  size_t max_room_members;
+};
+
+double GetProcessCpuSec() {
+  const auto times =
+      boost::chrono::process_cpu_clock::now().time_since_epoch().count();
+  // process_cpu_clock ticks are nanoseconds
+  return (times.user + times.system) / 1e9;
+}
+
+int64_t GetPeakRssKb() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (not GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                               sizeof(counters))) {
+    return 0;
+  }
+  return static_cast<int64_t>(counters.PeakWorkingSetSize / 1024);
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  return usage.ru_maxrss;
+#endif
+}
+
+void ResetRooms(const int room_count) {
+  std::vector<std::string> room_ids;
+  RoomManager::ForEachRoom([&room_ids](const std::shared_ptr<RoomActor>& room) {
+    room_ids.emplace_back(room->GetRoomId());
+  });
+  for (const auto& room_id : room_ids) {
+    RoomManager::EraseRoom(room_id);
+  }
+  for (int i = 0; i < room_count; ++i) {
+    RoomManager::CreateRoom();
+  }
+}
+
+bool WaitForDrain() {
+  for (int waited = 0; waited < DRAIN_TIMEOUT_MSEC; waited += 100) {
+    if (Connection::GetCunnectionCount() == 0) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  return false;
+}
+
+ScenarioResult RunScenario(const Scenario& scenario, const double scale,
+                           const int duration_sec, const int io_threads,
+                           const unsigned short port) {
+  ScenarioResult result;
+  result.scenario = &scenario;
+  result.connections =
+      std::max(1, static_cast<int>(scenario.connections * scale));
+
+  ResetRooms(scenario.rooms);
+
+  LoadOptions options;
+  options.port = std::to_string(port);
+  options.connections = result.connections;
+  options.io_threads = io_threads;
+  options.connect_per_sec = scenario.connect_per_sec;
+  options.chat_per_sec = scenario.chat_per_sec;
+  options.burst_size = scenario.burst_size;
+  options.duration_sec = duration_sec;
+
+  std::cerr << "e2e_bench: " << scenario.name << " (" << result.connections
+            << " connections, " << scenario.rooms << " rooms)\n";
+
+  const double cpu_begin_sec = GetProcessCpuSec();
+  LoadGenerator generator(options);
+  if (generator.Start()) {
+    std::this_thread::sleep_for(std::chrono::seconds(duration_sec));
+  }
+
+  // room occupancy is sampled before the bots leave
+  result.rooms_used = 0;
+  result.max_room_members = 0;
+  for (const size_t members : RoomManager::GetRoomMemberCounts()) {
+    result.rooms_used += (members > 0) ? 1 : 0;
+    result.max_room_members = std::max(result.max_room_members, members);
+  }
+
+  generator.Stop();
+  if (not WaitForDrain()) {
+    Log::Print(Log::Level::WARNING,
+               "e2e_bench: sessions still open after " +
+                   std::string(scenario.name));
+  }
+
+  result.load = generator.GetSummary();
+  result.server_cpu_sec = std::max(
+      0.0, GetProcessCpuSec() - cpu_begin_sec - result.load.client_cpu_sec);
+  result.peak_rss_kb = GetPeakRssKb();
+  return result;
+}
+
+void WriteHistogram(const char* name, const LatencyHistogram& histogram,
+                    std::ostringstream* out) {
+  *out << "        \"" << name << "\": {\"count\": " << histogram.Count()
+       << ", \"p50\": " << histogram.Percentile(50.0)
+       << ", \"p90\": " << histogram.Percentile(90.0)
+       << ", \"p99\": " << histogram.Percentile(99.0)
+       << ", \"p99_9\": " << histogram.Percentile(99.9)
+       << ", \"max\": " << histogram.Max() << "}";
+}
+
+std::string ToJson(const std::vector<ScenarioResult>& results,
+                   const int duration_sec, const double scale) {
+  const std::time_t now = std::time(nullptr);
+  char date[32] = "";
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  out << "{\n  \"context\": {\n"
+      << "    \"date\": \"" << date << "\",\n"
+      << "    \"executable\": \"e2e_bench\",\n"
+      << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+      << "    \"library_build_type\": \"release\",\n"
+#else
+      << "    \"library_build_type\": \"debug\",\n"
+#endif
+      << "    \"duration_sec\": " << duration_sec << ",\n"
+      << "    \"scale\": " << scale << "\n  },\n"
+      << "  \"scenarios\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& result = results[i];
+    const auto& load = result.load;
+    const auto& latency = load.latency;
+    // every frame the server handled: client requests plus what it sent
+    const uint64_t messages = load.sent + load.received;
+    out << (i == 0 ? "\n" : ",\n") << "    {\n"
+        << "      \"name\": \"" << result.scenario->name << "\",\n"
+        << "      \"connections\": " << result.connections << ",\n"
+        << "      \"rooms\": " << result.scenario->rooms << ",\n"
+        << "      \"rooms_used\": " << result.rooms_used << ",\n"
+        << "      \"max_room_members\": " << result.max_room_members << ",\n"
+        << "      \"elapsed_sec\": " << load.elapsed_sec << ",\n"
+        << "      \"connected\": " << load.connected << ",\n"
+        << "      \"connect_failed\": " << load.connect_failed << ",\n"
+        << "      \"sent\": " << load.sent << ",\n"
+        << "      \"received\": " << load.received << ",\n"
+        << "      \"send_dropped\": " << load.send_dropped << ",\n"
+        << "      \"send_deferred\": " << load.send_deferred << ",\n"
+        << "      \"malformed\": " << load.malformed << ",\n"
+        << "      \"error_acks\": " << load.error_acks << ",\n"
+        << "      \"sent_per_second\": " << load.sent / load.elapsed_sec
+        << ",\n"
+        << "      \"received_per_second\": "
+        << load.received / load.elapsed_sec << ",\n"
+        << "      \"delivered\": " << latency.delivered << ",\n"
+        << "      \"missing\": " << latency.missing << ",\n"
+        << "      \"unacked\": " << latency.unacked << ",\n"
+        << "      \"unsent\": " << latency.unsent << ",\n"
+        << "      \"latency_usec\": {\n";
+    WriteHistogram("register", latency.register_usec, &out);
+    out << ",\n";
+    WriteHistogram("ack", latency.ack_usec, &out);
+    out << ",\n";
+    WriteHistogram("delivery", latency.delivery_usec, &out);
+    out << "\n      },\n"
+        << "      \"server_cpu_sec\": " << result.server_cpu_sec << ",\n"
+        << "      \"client_cpu_sec\": " << load.client_cpu_sec << ",\n"
+        << "      \"server_cpu_usec_per_message\": "
+        << (messages == 0 ? 0.0 : result.server_cpu_sec * 1e6 / messages)
+        << ",\n"
+        << "      \"peak_rss_kb\": " << result.peak_rss_kb << "\n"
+        << "    }";
+  }
+  out << "\n  ]\n}\n";
+  return out.str();
+}
+
+void PrintUsage() {
+  std::cerr << "usage: e2e_bench [options]\n"
+               "  --scenario=<name>   run one scenario (all)\n"
+               "  --scale=<x>         connection count multiplier (1.0)\n"
+               "  --duration=<sec>    load time per scenario (10)\n"
+               "  --io-threads=<n>    bot io threads (2)\n"
+               "  --out=<path>        write the json report to path\n"
+               "scenarios:";
+  for (const auto& scenario : SCENARIOS) {
+    std::cerr << " " << scenario.name;
+  }
+  std::cerr << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string scenario_filter;
+  std::string out_path;
+  double scale = 1.0;
+  int duration_sec = 10;
+  int io_threads = 2;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.compare(0, 11, "--scenario=") == 0) {
+      scenario_filter = arg.substr(11);
+    } else if (arg.compare(0, 8, "--scale=") == 0) {
+      scale = std::stod(arg.substr(8));
+    } else if (arg.compare(0, 11, "--duration=") == 0) {
+      duration_sec = std::max(1, std::stoi(arg.substr(11)));
+    } else if (arg.compare(0, 13, "--io-threads=") == 0) {
+      io_threads = std::max(1, std::stoi(arg.substr(13)));
+    } else if (arg.compare(0, 6, "--out=") == 0) {
+      out_path = arg.substr(6);
+    } else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  std::vector<const Scenario*> scenarios;
+  for (const auto& scenario : SCENARIOS) {
+    if (scenario_filter.empty() or scenario_filter == scenario.name) {
+      scenarios.emplace_back(&scenario);
+    }
+  }
+  if (scenarios.empty()) {
+    PrintUsage();
+    return 1;
+  }
+
+  // ephemeral ports, so the bench runs next to a live server
+  NetworkManager::SetPorts(0, 0);
+  std::unique_ptr<Server> server = std::make_unique<Server>();
+  server->Start();
+  Log::SetLogLevel(Log::Level::WARNING);
+  const unsigned short port = NetworkManager::GetInstance()->GetListenPort();
+
+  std::vector<ScenarioResult> results;
+  for (const auto scenario : scenarios) {
+    results.emplace_back(
+        RunScenario(*scenario, scale, duration_sec, io_threads, port));
+  }
+
+  server->Stop();
+  server.reset();
+
+  const std::string json = ToJson(results, duration_sec, scale);
+  if (out_path.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream out(out_path, std::ios::out | std::ios::trunc);
+    out << json;
+  }
+  return 0;
+}
@@ -1,16 +1,35 @@
 #include "actor_base_model.h"
 
+#include <atomic>
+#include <thread>
+
+#include "clock.h"
+#include "json.h"
+#include "logger.h"
+#include "metrics.h"
 #include "thread_pool_manager.h"
 #include "timer_event_manager.h"
+#include "trace_recorder.h"
 #include "utility.h"
 
+namespace {
+
+std::atomic<size_t> next_affinity_key{0};
+
+}  // namespace
+
 ActorBaseModel::ActorBaseModel()
-    : recursive_interval_msec_(0), task_count_(0) {}
+    : ActorBaseModel(next_affinity_key.fetch_add(1)) {}
+
+ActorBaseModel::ActorBaseModel(const size_t affinity_key)
+    : recursive_interval_msec_(0),
+      affinity_key_(affinity_key),
+      task_count_(0),
+      is_overloaded_(false) {}
 
 ActorBaseModel::~ActorBaseModel() {
   std::function<void()> task;
-  while (not task_queue_.IsEmpty()) {
-    task_queue_.TryDequeue(&task);
+  while (control_queue_.TryDequeue(&task) or bulk_queue_.TryDequeue(&task)) {
   }
   task_count_ = 0;
 }
@@ -20,20 +39,29 @@ void ActorBaseModel::StartRecursiveEvent(const int64_t inteval_msec) {
 
   recursive_interval_msec_ = inteval_msec;
   const int64_t expected_msec =
-      Utility::GetMillisTimestampFromNow() + recursive_interval_msec_;
+      Clock::GetMillis() + recursive_interval_msec_;
 
   if (is_first) {
     SelfEvent(expected_msec);
   }
 }
 
-void ActorBaseModel::AsyncTask(const std::function<void()>& task) {
-  task_queue_.Enqueue(task);
+void ActorBaseModel::AsyncTask(const std::function<void()>& task,
+                               const MailboxLane lane) {
+  if (lane == MailboxLane::CONTROL) {
+    control_queue_.Enqueue(task);
+  } else {
+    bulk_queue_.Enqueue(task);
+  }
 
-  if (++task_count_ == 1) {
+  const int task_count = ++task_count_;
+  if (task_count >= MAILBOX_HIGH_WATERMARK and not is_overloaded_.load()) {
+    SetOverloaded();
+  }
+  if (task_count == 1) {
     auto self = shared_from_this();
     ThreadPoolManager::GetInstance()->PushTask(
-        [this, self]() { FlushEvent(); });
+        [this, self]() { FlushEvent(); }, affinity_key_);
   }
 }
 
@@ -43,12 +71,28 @@ void ActorBaseModel::AsyncTask(const std::function<void()>& task,
   TimerEventManager::GetInstance()->InvokeEvent(self, task, delay_msec);
 }
 
+bool ActorBaseModel::WaitForDrain(const std::function<void()>& on_drained) {
+  boost::lock_guard<boost::detail::spinlock> lock{drain_lock_};
+  if (not is_overloaded_.load()) {
+    return false;
+  }
+  drain_waiters_.emplace_back(on_drained);
+  return true;
+}
+
+void ActorBaseModel::SendAsyncEvent(const int type,
+                                    const std::shared_ptr<IEventData>&) {
+  Log::Print(Log::Level::ERROR_, std::string(GetActorType()) +
+                                     "::SendAsyncEvent(" +
+                                     std::to_string(type) + "): no events");
+}
+
 void ActorBaseModel::SelfEvent(const int64_t expected_msec) {
   if (recursive_interval_msec_ == 0) {
     return;
   }
 
-  const int64_t now_msec = Utility::GetMillisTimestampFromNow();
+  const int64_t now_msec = Clock::GetMillis();
   int64_t delay_msec = 0;
   if (now_msec > expected_msec) {
     delay_msec = recursive_interval_msec_ - (now_msec - expected_msec);
@@ -65,13 +109,81 @@ void ActorBaseModel::SelfEvent(const int64_t expected_msec) {
 }
 
 void ActorBaseModel::FlushEvent() {
+  const bool is_recording = TraceRecorder::IsRecording();
+  const int64_t begin_usec = is_recording ? Clock::GetMicros() : 0;
+  int64_t message_count = 0;
+
   std::function<void()> task;
+  int control_run = 0;
 
+  // task_count_ drops only after a task ran, so an AsyncTask meanwhile
+  // can't schedule a second FlushEvent next to this one. a counted task is
+  // already in its lane, the count is raised after the enqueue
+  ThreadPoolManager::SetCurrentActor(shared_from_this());
   while (true) {
-    if (not task_queue_.TryDequeue(&task)) {
-      break;
+    while (not PopTask(&control_run, &task)) {
+      std::this_thread::yield();
     }
-    --task_count_;
+    JsonArena::Scope json_scope;
     task();
+    ++message_count;
+
+    const int task_count = --task_count_;
+    if (task_count <= MAILBOX_LOW_WATERMARK and is_overloaded_.load()) {
+      ClearOverloaded();
+    }
+    if (task_count == 0) {
+      break;
+    }
+  }
+  ThreadPoolManager::SetCurrentActor(nullptr);
+
+  if (is_recording) {
+    TraceRecorder::AddActivation(GetActorType(), GetActorId(), message_count,
+                                 begin_usec, Clock::GetMicros());
+  }
+}
+
+bool ActorBaseModel::PopTask(int* control_run, std::function<void()>* task) {
+  if (*control_run < MAILBOX_CONTROL_BURST and
+      control_queue_.TryDequeue(task)) {
+    ++*control_run;
+    return true;
+  }
+  if (bulk_queue_.TryDequeue(task)) {
+    *control_run = 0;
+    return true;
+  }
+  if (control_queue_.TryDequeue(task)) {
+    *control_run = 1;
+    return true;
+  }
+  return false;
+}
+
+void ActorBaseModel::SetOverloaded() {
+  boost::lock_guard<boost::detail::spinlock> lock{drain_lock_};
+  if (is_overloaded_.load()) {
+    return;
+  }
+  // the flag goes up before the count is read again and FlushEvent counts
+  // down before it reads the flag, so one of them sees the other
+  is_overloaded_.store(true);
+  if (task_count_.load() <= MAILBOX_LOW_WATERMARK) {
+    is_overloaded_.store(false);
+    return;
+  }
+  Metrics::AddMailboxOverload();
+}
+
+void ActorBaseModel::ClearOverloaded() {
+  std::vector<std::function<void()>> waiters;
+  {
+    boost::lock_guard<boost::detail::spinlock> lock{drain_lock_};
+    is_overloaded_.store(false);
+    waiters.swap(drain_waiters_);
+  }
+  for (const auto& on_drained : waiters) {
+    on_drained();
   }
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "concurrent_queue.h"
 
@@ -13,27 +15,61 @@ struct IEventData {
   virtual ~IEventData() = default;
 };
 
+//:
+//: mailbox lane of a task
+//: CONTROL (membership, session lifecycle, client requests) runs ahead of
+//: BULK (chat fan-out, timers), BULK still gets a turn after
+//: MAILBOX_CONTROL_BURST control tasks in a row
+//:
+enum class MailboxLane {
+  CONTROL,
+  BULK,
+};
+
 //:
 //: actor base class
 //:
 class ActorBaseModel : public std::enable_shared_from_this<ActorBaseModel> {
  public:
   ActorBaseModel();
+  //: actors with the same key share a home worker in affinity mode
+  explicit ActorBaseModel(const size_t affinity_key);
   virtual ~ActorBaseModel();
 
   void StartRecursiveEvent(const int64_t inteval_msec);
-  void AsyncTask(const std::function<void()>& task);
+  void AsyncTask(const std::function<void()>& task,
+                 const MailboxLane lane = MailboxLane::BULK);
   void AsyncTask(const std::function<void()>& task, const int64_t delay_msec);
 
+  virtual const char* GetActorType() const { return "Actor"; }
+  virtual std::string GetActorId() const { return ""; }
+  int GetMailboxDepth() const { return task_count_.load(); }
+
+  //: set once the mailbox reaches MAILBOX_HIGH_WATERMARK, cleared when it is
+  //: drained down to MAILBOX_LOW_WATERMARK
+  bool IsOverloaded() const { return is_overloaded_.load(); }
+  //: on_drained runs on the draining worker when the overload clears,
+  //: false (and on_drained dropped) if the actor isn't overloaded
+  bool WaitForDrain(const std::function<void()>& on_drained);
+
  protected:
   virtual void SelfEvent(const int64_t expected_msec);
+  //: an actor that takes no events keeps this one, it only logs
   virtual void SendAsyncEvent(const int type,
-                              const std::shared_ptr<IEventData>&) = 0;
+                              const std::shared_ptr<IEventData>&);
 
  private:
   int64_t recursive_interval_msec_;
-  std::atomic<int> task_count_;
-  ConcurrentQueue<std::function<void()>> task_queue_;
+  const size_t affinity_key_;
+  std::atomic<int> task_count_;  // both lanes
+  std::atomic<bool> is_overloaded_;
+  boost::detail::spinlock drain_lock_ = BOOST_DETAIL_SPINLOCK_INIT;
+  std::vector<std::function<void()>> drain_waiters_;
+  ConcurrentQueue<std::function<void()>> control_queue_;
+  ConcurrentQueue<std::function<void()>> bulk_queue_;
 
   void FlushEvent();
+  void SetOverloaded();
+  void ClearOverloaded();
+  bool PopTask(int* control_run, std::function<void()>* task);
 };
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "chat_batch.h"
+
+#include <algorithm>
+
+#include "session.h"
+
+namespace {
+
+//: bytes WriteJson() gives value, quotes and escapes included
+size_t GetJsonLength(const std::string& value) {
+  size_t length = value.size() + 2;
+  for (const char c : value) {
+    const char escape =
+        Protocol::Detail::GetEscape(static_cast<unsigned char>(c));
+    if (escape != 0) {
+      length += (escape == 'u') ? 5 : 1;
+    }
+  }
+  return length;
+}
+
+}  // namespace
+
+ChatBatch::ChatBatch(const Protocol::BroadcastingChatBatch& chats) {
+  const size_t size =
+      std::min(chats.senders.size(), chats.chat_messages.size());
+
+  // JSON is never shorter than BINARY, a part whose JSON frame fits fits
+  // both. the frame length is tracked as lines are added, starting from a
+  // frame without any
+  Protocol::BroadcastingChatBatch part;
+  part.result = chats.result;
+  const size_t empty_length =
+      SimpleMessage::MakeMessage(part, Codec::JSON).body_length();
+  size_t length = empty_length;
+  for (size_t i = 0; i < size; ++i) {
+    const size_t line_length =
+        GetJsonLength(chats.senders[i]) + GetJsonLength(chats.chat_messages[i]);
+    // OnSendChatMessage turns these away, one that got here anyway is left
+    // out rather than sent as an empty frame
+    if (empty_length + line_length > SimpleMessage::max_body_length) {
+      continue;
+    }
+    // a line after the first adds a comma to both lists
+    if (not part.senders.empty() and
+        length + line_length + 2 > SimpleMessage::max_body_length) {
+      AddPart(std::move(part));
+      part = Protocol::BroadcastingChatBatch();
+      part.result = chats.result;
+      length = empty_length;
+    }
+    length += line_length + (part.senders.empty() ? 0 : 2);
+    part.senders.emplace_back(chats.senders[i]);
+    part.chat_messages.emplace_back(chats.chat_messages[i]);
+  }
+  if (not part.senders.empty()) {
+    AddPart(std::move(part));
+  }
+}
+
+bool ChatBatch::FitsFrame(const std::string& sender,
+                         const std::string& chat_message) {
+  // a one line part is longer than the BroadcastingChat of the line, the
+  // lists add brackets and longer keys
+  static const size_t empty_length = []() {
+    Protocol::BroadcastingChatBatch part;
+    part.result = static_cast<int>(ResultType::Sucess);
+    return SimpleMessage::MakeMessage(part, Codec::JSON).body_length();
+  }();
+  return empty_length + GetJsonLength(sender) + GetJsonLength(chat_message) <=
+         SimpleMessage::max_body_length;
+}
+
+void ChatBatch::AddPart(Protocol::BroadcastingChatBatch&& chats) {
+  Part part;
+  part.chats = std::move(chats);
+  for (const Codec codec : {Codec::JSON, Codec::BINARY}) {
+    part.frames[static_cast<int>(codec)] =
+        std::make_shared<const SimpleMessage>(
+            SimpleMessage::MakeMessage(part.chats, codec));
+  }
+  parts_.emplace_back(std::move(part));
+}
+
+void ChatBatch::Send(const std::shared_ptr<Session>& session,
+                     const std::string& nickname) const {
+  const Codec codec = session->GetCodec();
+  for (const auto& part : parts_) {
+    const auto& senders = part.chats.senders;
+    if (std::find(senders.begin(), senders.end(), nickname) ==
+        senders.end()) {
+      session->SendBroadcast(part.frames[static_cast<int>(codec)], "");
+      continue;
+    }
+
+    // own lines are left out like the echo of a single chat
+    Protocol::BroadcastingChatBatch others;
+    others.result = part.chats.result;
+    for (size_t i = 0; i < senders.size(); ++i) {
+      if (senders[i] != nickname) {
+        others.senders.emplace_back(senders[i]);
+        others.chat_messages.emplace_back(part.chats.chat_messages[i]);
+      }
+    }
+    if (others.senders.empty()) {
+      continue;
+    }
+    session->SendBroadcast(std::make_shared<const SimpleMessage>(
+                               SimpleMessage::MakeMessage(others, codec)),
+                           "");
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "messages.h"
+#include "simple_message.h"
+
+class Session;
+
+//:
+//: chats a room collected over one batching window, split into parts whose
+//: BroadcastingChatBatch frame fits max_body_length
+//: a part is encoded once per codec and shared by every member that didn't
+//: write one of its lines, a sender gets it again without its own lines
+//:
+class ChatBatch {
+ public:
+  explicit ChatBatch(const Protocol::BroadcastingChatBatch& chats);
+
+  //: false if the line is too long for any frame, alone in a
+  //: BroadcastingChatBatch part or as a BroadcastingChat
+  static bool FitsFrame(const std::string& sender,
+                        const std::string& chat_message);
+
+  size_t GetPartCount() const { return parts_.size(); }
+
+  void Send(const std::shared_ptr<Session>& session,
+            const std::string& nickname) const;
+
+ private:
+  struct Part {
+    Protocol::BroadcastingChatBatch chats;
+    std::shared_ptr<const SimpleMessage> frames[2];  // by Codec
+  };
+
+  std::vector<Part> parts_;
+
+  void AddPart(Protocol::BroadcastingChatBatch&& chats);
+};
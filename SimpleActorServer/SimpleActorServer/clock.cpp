@@ -0,0 +1,58 @@
+#include "clock.h"
+
+#include <boost/thread.hpp>
+#include <atomic>
+#include <memory>
+
+#include "utility.h"
+
+namespace {
+
+std::atomic<int64_t> wall_msec{0};  // 0 while the ticker isn't running
+boost::mutex ticker_lock;
+std::unique_ptr<boost::thread> ticker;
+
+int64_t ReadWallMillis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+void RunTicker() {
+  try {
+    while (true) {
+      boost::this_thread::interruption_point();
+      wall_msec.store(ReadWallMillis(), std::memory_order_relaxed);
+      boost::this_thread::sleep_for(
+          boost::chrono::milliseconds(CLOCK_TICK_MSEC));
+    }
+  } catch (...) {
+  }
+}
+
+}  // namespace
+
+int64_t Clock::GetWallMillis() {
+  const int64_t cached = wall_msec.load(std::memory_order_relaxed);
+  return (cached != 0) ? cached : ReadWallMillis();
+}
+
+void Clock::Start() {
+  boost::lock_guard<boost::mutex> lock{ticker_lock};
+  if (!!ticker) {
+    return;
+  }
+  wall_msec.store(ReadWallMillis());
+  ticker = std::make_unique<boost::thread>(RunTicker);
+}
+
+void Clock::Stop() {
+  boost::lock_guard<boost::mutex> lock{ticker_lock};
+  if (not ticker) {
+    return;
+  }
+  ticker->interrupt();
+  ticker->join();
+  ticker.reset();
+  wall_msec.store(0);
+}
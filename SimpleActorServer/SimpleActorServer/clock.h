@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+//:
+//: monotonic  steady_clock, for durations, deadlines and timers. an ntp
+//:            step or a DST change never moves it, so timers can't fire
+//:            early or stall
+//: wall       unix time cached by a ticker thread every CLOCK_TICK_MSEC,
+//:            for logs and file names only
+//:
+namespace Clock {
+
+inline int64_t GetMillis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+inline int64_t GetMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+//: reads system_clock itself while the ticker isn't running
+int64_t GetWallMillis();
+
+void Start();
+void Stop();
+
+}  // namespace Clock
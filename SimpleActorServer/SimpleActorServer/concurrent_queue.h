@@ -1,57 +1,357 @@
 #pragma once
 
-#include <concurrent_queue.h>
-
+#include <boost/smart_ptr/detail/spinlock.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <algorithm>
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "utility.h"
 
+namespace ConcurrentQueueDetail {
+
+const size_t CACHE_LINE = 64;
+
+//:
+//: hazard pointer of one thread, shared by every queue
+//: a queue operation publishes the segment it works on here, a segment
+//: found in any slot isn't deleted
+//:
+struct HazardSlot {
+  std::atomic<void*> pointer{nullptr};
+  std::atomic<bool> in_use{false};
+  HazardSlot* next = nullptr;
+  char pad_[CACHE_LINE];
+};
+
+inline std::atomic<HazardSlot*>& GetHazardSlots() {
+  static std::atomic<HazardSlot*> slots{nullptr};
+  return slots;
+}
+
+//: slots are never freed, a thread that exits leaves its slot for the next
+class ThreadHazard {
+ public:
+  ThreadHazard() {
+    auto& slots = GetHazardSlots();
+    for (HazardSlot* slot = slots.load(); slot != nullptr; slot = slot->next) {
+      bool expected = false;
+      if (slot->in_use.compare_exchange_strong(expected, true)) {
+        slot_ = slot;
+        return;
+      }
+    }
+    slot_ = new HazardSlot();
+    slot_->in_use.store(true);
+    slot_->next = slots.load();
+    while (not slots.compare_exchange_weak(slot_->next, slot_)) {
+    }
+  }
+  ~ThreadHazard() {
+    slot_->pointer.store(nullptr);
+    slot_->in_use.store(false);
+  }
+
+  HazardSlot* Get() const { return slot_; }
+
+ private:
+  HazardSlot* slot_;
+};
+
+inline HazardSlot* GetThreadHazard() {
+  thread_local ThreadHazard hazard;
+  return hazard.Get();
+}
+
+inline bool IsHazard(const void* pointer) {
+  for (HazardSlot* slot = GetHazardSlots().load(); slot != nullptr;
+       slot = slot->next) {
+    if (slot->pointer.load() == pointer) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace ConcurrentQueueDetail
+
 //:
 //: Thread Safe Queue
 //: thread safe Size Լ 
 //:
-template <typename T>
+//: MPMC queue as a linked list of fixed size segments
+//: producers and consumers claim slots with fetch_add / CAS on the segment
+//: indexes, each slot carries a ready flag so a consumer only waits for the
+//: producer that already owns its slot
+//: a drained segment is unlinked and deleted as soon as no thread's
+//: hazard pointer holds it
+//: the first segment comes with the first value, an actor that never got
+//: a message costs no segment
+//:
+template <typename T, size_t SEGMENT_SIZE = 32>
 class ConcurrentQueue {
  public:
-  ConcurrentQueue() : count_(0) {}
-  ~ConcurrentQueue() {
-    T tmp;
-    while (not queue_.empty()) {
-      queue_.try_pop(tmp);
-    }
-  }
+  //: capacity 0 is unbounded, otherwise TryEnqueue() fails when full
+  explicit ConcurrentQueue(const size_t capacity = 0);
+  ~ConcurrentQueue();
+
+  ConcurrentQueue(const ConcurrentQueue&) = delete;
+  ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
 
   void Enqueue(const T& value);
+  bool TryEnqueue(const T& value);
   bool TryDequeue(T* value);
   bool IsEmpty();
   size_t Size();
 
  private:
+  static const size_t CACHE_LINE = ConcurrentQueueDetail::CACHE_LINE;
+
+  struct Slot {
+    std::atomic<uint32_t> ready;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    T* Get() { return reinterpret_cast<T*>(&storage); }
+  };
+
+  struct Segment {
+    std::atomic<size_t> enqueue_index;
+    char pad1_[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> dequeue_index;
+    char pad2_[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<Segment*> next;
+    Slot slots[SEGMENT_SIZE];
+
+    Segment() : enqueue_index(0), dequeue_index(0), next(nullptr) {
+      for (auto& slot : slots) {
+        slot.ready.store(0, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  //: publishes the segment in src, valid once src still points to it
+  //: while a segment is protected only T's copy / move constructor and the
+  //: destructor of a moved-from value run, neither reaches another queue,
+  //: so a nested queue call can't take the slot over
+  class Protect {
+   public:
+    Protect() : slot_(ConcurrentQueueDetail::GetThreadHazard()) {}
+    ~Protect() { Clear(); }
+
+    void Clear() { slot_->pointer.store(nullptr, std::memory_order_release); }
+
+    Segment* Load(const std::atomic<Segment*>& src) {
+      Segment* segment = src.load();
+      while (true) {
+        slot_->pointer.store(segment);
+        Segment* current = src.load();
+        if (current == segment) {
+          return segment;
+        }
+        segment = current;
+      }
+    }
+
+   private:
+    ConcurrentQueueDetail::HazardSlot* slot_;
+  };
+
+  void Push(const T& value);
+  bool PushFirst(const T& value);
+  void Retire(Segment* segment);
+
+  const size_t capacity_;
   std::atomic<size_t> count_;
-  concurrency::concurrent_queue<T> queue_;
+  char pad1_[CACHE_LINE - sizeof(std::atomic<size_t>)];
+  std::atomic<Segment*> head_;
+  char pad2_[CACHE_LINE - sizeof(std::atomic<Segment*>)];
+  std::atomic<Segment*> tail_;
+  char pad3_[CACHE_LINE - sizeof(std::atomic<Segment*>)];
+
+  boost::detail::spinlock retire_lock_ = BOOST_DETAIL_SPINLOCK_INIT;
+  std::vector<Segment*> retired_;
 };
 
-template <typename T>
-void ConcurrentQueue<T>::Enqueue(const T& value) {
-  queue_.push(value);
+template <typename T, size_t SEGMENT_SIZE>
+ConcurrentQueue<T, SEGMENT_SIZE>::ConcurrentQueue(const size_t capacity)
+    : capacity_(capacity), count_(0), head_(nullptr), tail_(nullptr) {}
+
+template <typename T, size_t SEGMENT_SIZE>
+ConcurrentQueue<T, SEGMENT_SIZE>::~ConcurrentQueue() {
+  Segment* segment = head_.load();
+  while (segment != nullptr) {
+    const size_t end = std::min(segment->enqueue_index.load(), SEGMENT_SIZE);
+    for (size_t i = segment->dequeue_index.load(); i < end; ++i) {
+      segment->slots[i].Get()->~T();
+    }
+    Segment* next = segment->next.load();
+    delete segment;
+    segment = next;
+  }
+  for (Segment* retired : retired_) {
+    delete retired;
+  }
+}
+
+template <typename T, size_t SEGMENT_SIZE>
+void ConcurrentQueue<T, SEGMENT_SIZE>::Enqueue(const T& value) {
   count_.fetch_add(1);
+  Push(value);
 }
 
-template <typename T>
-bool ConcurrentQueue<T>::TryDequeue(T* retVal) {
-  if (queue_.try_pop(*retVal)) {
+template <typename T, size_t SEGMENT_SIZE>
+bool ConcurrentQueue<T, SEGMENT_SIZE>::TryEnqueue(const T& value) {
+  if (count_.fetch_add(1) >= capacity_ and capacity_ != 0) {
     count_.fetch_sub(1);
+    return false;
+  }
+  Push(value);
+  return true;
+}
+
+template <typename T, size_t SEGMENT_SIZE>
+void ConcurrentQueue<T, SEGMENT_SIZE>::Push(const T& value) {
+  Protect protect;
+  while (true) {
+    Segment* tail = protect.Load(tail_);
+    if (tail == nullptr) {
+      if (PushFirst(value)) {
+        return;
+      }
+      continue;
+    }
+    const size_t index = tail->enqueue_index.fetch_add(1);
+    if (index < SEGMENT_SIZE) {
+      Slot& slot = tail->slots[index];
+      new (slot.Get()) T(value);
+      slot.ready.store(1, std::memory_order_release);
+      return;
+    }
+
+    // full, link a new segment that already holds the value
+    Segment* next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      Segment* segment = new Segment();
+      segment->enqueue_index.store(1, std::memory_order_relaxed);
+      new (segment->slots[0].Get()) T(value);
+      segment->slots[0].ready.store(1, std::memory_order_relaxed);
+      if (tail->next.compare_exchange_strong(next, segment)) {
+        tail_.compare_exchange_strong(tail, segment);
+        return;
+      }
+      segment->slots[0].Get()->~T();
+      delete segment;
+    }
+    tail_.compare_exchange_strong(tail, next);
+  }
+}
+
+//: head_ is set first and never goes back to nullptr, a producer that
+//: finds only the tail missing helps it along and retries
+template <typename T, size_t SEGMENT_SIZE>
+bool ConcurrentQueue<T, SEGMENT_SIZE>::PushFirst(const T& value) {
+  Segment* head = head_.load();
+  if (head != nullptr) {
+    Segment* tail = nullptr;
+    tail_.compare_exchange_strong(tail, head);
+    return false;
+  }
+
+  Segment* segment = new Segment();
+  segment->enqueue_index.store(1, std::memory_order_relaxed);
+  new (segment->slots[0].Get()) T(value);
+  segment->slots[0].ready.store(1, std::memory_order_relaxed);
+  if (head_.compare_exchange_strong(head, segment)) {
+    Segment* tail = nullptr;
+    tail_.compare_exchange_strong(tail, segment);
     return true;
   }
+  segment->slots[0].Get()->~T();
+  delete segment;
   return false;
 }
 
-template <typename T>
-bool ConcurrentQueue<T>::IsEmpty() {
-  return queue_.empty();
+template <typename T, size_t SEGMENT_SIZE>
+bool ConcurrentQueue<T, SEGMENT_SIZE>::TryDequeue(T* value) {
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  T* item = reinterpret_cast<T*>(&storage);
+  {
+    Protect protect;
+    while (true) {
+      Segment* head = protect.Load(head_);
+      if (head == nullptr) {
+        return false;
+      }
+      size_t index = head->dequeue_index.load(std::memory_order_acquire);
+      if (index >= SEGMENT_SIZE) {
+        Segment* next = head->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+          return false;
+        }
+        if (head_.compare_exchange_strong(head, next)) {
+          // a producer may not have moved the tail yet
+          Segment* tail = head;
+          tail_.compare_exchange_strong(tail, next);
+          // the next Load() publishes again, head isn't touched after this
+          protect.Clear();
+          Retire(head);
+        }
+        continue;
+      }
+      if (index >= head->enqueue_index.load(std::memory_order_acquire)) {
+        return false;
+      }
+      if (not head->dequeue_index.compare_exchange_weak(index, index + 1)) {
+        continue;
+      }
+
+      // the slot is claimed by a producer that may still be writing it
+      Slot& slot = head->slots[index];
+      while (slot.ready.load(std::memory_order_acquire) == 0) {
+        std::this_thread::yield();
+      }
+      new (item) T(std::move(*slot.Get()));
+      slot.Get()->~T();
+      break;
+    }
+  }
+  count_.fetch_sub(1);
+  // assigning may destroy the old value, which can reach another queue
+  *value = std::move(*item);
+  item->~T();
+  return true;
+}
+
+//: a segment nobody holds is deleted right away, one another thread still
+//: holds waits for the next retire
+template <typename T, size_t SEGMENT_SIZE>
+void ConcurrentQueue<T, SEGMENT_SIZE>::Retire(Segment* segment) {
+  // head_ and tail_ moved past the segment, no new hazard can point to it
+  boost::lock_guard<boost::detail::spinlock> lock{retire_lock_};
+  retired_.push_back(segment);
+  size_t kept = 0;
+  for (Segment* retired : retired_) {
+    if (ConcurrentQueueDetail::IsHazard(retired)) {
+      retired_[kept++] = retired;
+    } else {
+      delete retired;
+    }
+  }
+  retired_.resize(kept);
+}
+
+template <typename T, size_t SEGMENT_SIZE>
+bool ConcurrentQueue<T, SEGMENT_SIZE>::IsEmpty() {
+  return count_.load() == 0;
 }
 
-template <typename T>
-size_t ConcurrentQueue<T>::Size() {
+template <typename T, size_t SEGMENT_SIZE>
+size_t ConcurrentQueue<T, SEGMENT_SIZE>::Size() {
   return count_.load();
-}
\ No newline at end of file
+}
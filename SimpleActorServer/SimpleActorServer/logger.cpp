@@ -1,10 +1,11 @@
 #include "logger.h"
 
-#include <Windows.h>
-
+#include <ctime>
 #include <iostream>
 #include <thread>
 
+#include "clock.h"
+
 namespace {
 
 static Log::Level LOG_LEVEL = Log::Level::DEBUG;
@@ -13,14 +14,28 @@ static Log::Level LOG_LEVEL = Log::Level::DEBUG;
 
 void Log::SetLogLevel(const Level level) { LOG_LEVEL = level; }
 
+bool Log::IsEnabled(const Level level) { return level >= LOG_LEVEL; }
+
 void Log::Print(const Level level, const std::string& v) {
   if (level < LOG_LEVEL) {
     return;
   }
-  SYSTEMTIME cur_time;
-  GetLocalTime(&cur_time);
-  std::cout << "[" << cur_time.wYear << "-" << cur_time.wMonth << "-"
-            << cur_time.wDay << " " << cur_time.wHour << ":" << cur_time.wMinute
-            << ":" << cur_time.wSecond << " " << cur_time.wMilliseconds << "] ["
-            << std::this_thread::get_id() << "]\t" << v << std::endl;
+  // localtime only runs when the second changes on this thread
+  thread_local std::time_t cached_sec = -1;
+  thread_local std::tm cur_time;
+  const int64_t now_msec = Clock::GetWallMillis();
+  const std::time_t now_sec = static_cast<std::time_t>(now_msec / 1000);
+  const int64_t msec = now_msec % 1000;
+  if (now_sec != cached_sec) {
+#ifdef _WIN32
+    localtime_s(&cur_time, &now_sec);
+#else
+    localtime_r(&now_sec, &cur_time);
+#endif
+    cached_sec = now_sec;
+  }
+  std::cout << "[" << cur_time.tm_year + 1900 << "-" << cur_time.tm_mon + 1
+            << "-" << cur_time.tm_mday << " " << cur_time.tm_hour << ":"
+            << cur_time.tm_min << ":" << cur_time.tm_sec << " " << msec
+            << "] [" << std::this_thread::get_id() << "]\t" << v << std::endl;
 }
\ No newline at end of file
@@ -13,6 +13,7 @@ class Log {
   };
 
   static void SetLogLevel(const Level level);
+  static bool IsEnabled(const Level level);
 
   static void Print(const Level level, const std::string& v);
 };
\ No newline at end of file
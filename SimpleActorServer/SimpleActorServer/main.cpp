@@ -1,7 +1,15 @@
+#include <chrono>
 #include <iostream>
+#include <thread>
 
+#include "clock.h"
 #include "logger.h"
+#include "room_manager.h"
 #include "server.h"
+#include "session.h"
+#include "session_capture.h"
+#include "trace_recorder.h"
+#include "utility.h"
 
 int main() {
   std::unique_ptr<Server> server = std::make_unique<Server>();
@@ -13,8 +21,44 @@ int main() {
     if (command == "exit" or command == "q") {
       server->Stop();
       server.reset();
-      Sleep(1000);
+      std::this_thread::sleep_for(std::chrono::seconds(1));
       break;
+    } else if (command == "trace_start") {
+      TraceRecorder::Start();
+    } else if (command == "trace_stop") {
+      TraceRecorder::Stop();
+    } else if (command == "trace_dump") {
+      TraceRecorder::Dump(
+          "trace_" +
+          std::to_string(Clock::GetWallMillis()) + ".json");
+    } else if (command == "capture_start" or command == "capture_start_raw") {
+      // chat text is scrubbed unless the raw capture is asked for
+      SessionCapture::Start(
+          "capture_" +
+              std::to_string(Clock::GetWallMillis()) + ".sacap",
+          command == "capture_start");
+    } else if (command == "capture_stop") {
+      SessionCapture::Stop();
+    } else if (command == "outbound_policy") {
+      std::string policy;
+      std::cin >> policy;
+      if (policy == "drop_oldest") {
+        Session::SetOutboundPolicy(OutboundPolicy::DROP_OLDEST);
+      } else if (policy == "coalesce") {
+        Session::SetOutboundPolicy(OutboundPolicy::COALESCE);
+      } else if (policy == "disconnect") {
+        Session::SetOutboundPolicy(OutboundPolicy::DISCONNECT);
+      } else {
+        Log::Print(Log::Level::WARNING,
+                   "outbound_policy: drop_oldest, coalesce or disconnect");
+      }
+    } else if (command == "chat_batch") {
+      // only rooms open now, new ones start with ROOM_CHAT_BATCH_MSEC
+      int64_t msec = 0;
+      std::cin >> msec;
+      RoomManager::ForEachRoom([msec](const std::shared_ptr<RoomActor>& room) {
+        room->SetChatBatchWindow(msec);
+      });
     }
   }
 
@@ -0,0 +1,83 @@
+#include "member_table.h"
+
+#include "chat_batch.h"
+#include "messages.h"
+#include "session.h"
+#include "simple_message.h"
+#include "utility.h"
+
+bool MemberTable::Add(const std::string& session_id,
+                      const std::string& nickname,
+                      const std::shared_ptr<Session>& session) {
+  if (not indexes_.emplace(session_id, sessions_.size()).second) {
+    return false;
+  }
+  session_ids_.emplace_back(session_id);
+  nicknames_.emplace_back(nickname);
+  sessions_.emplace_back(session);
+  return true;
+}
+
+bool MemberTable::Remove(const std::string& session_id) {
+  const auto it = indexes_.find(session_id);
+  if (it == indexes_.end()) {
+    return false;
+  }
+
+  const size_t index = it->second;
+  const size_t last = sessions_.size() - 1;
+  indexes_.erase(it);
+  if (index != last) {
+    session_ids_[index] = std::move(session_ids_[last]);
+    nicknames_[index] = std::move(nicknames_[last]);
+    sessions_[index] = std::move(sessions_[last]);
+    indexes_[session_ids_[index]] = index;
+  }
+  session_ids_.pop_back();
+  nicknames_.pop_back();
+  sessions_.pop_back();
+  return true;
+}
+
+bool MemberTable::Rename(const std::string& session_id,
+                         const std::string& nickname) {
+  const auto it = indexes_.find(session_id);
+  if (it == indexes_.end()) {
+    return false;
+  }
+  nicknames_[it->second] = nickname;
+  return true;
+}
+
+void MemberTable::SendChat(const std::string& sender,
+                           const std::string& chat_message) const {
+  Protocol::BroadcastingChat chat;
+  chat.result = static_cast<int>(ResultType::Sucess);
+  chat.sender = sender;
+  chat.chat_message = chat_message;
+
+  std::shared_ptr<const SimpleMessage> frames[2];  // by Codec
+  for (size_t i = 0; i < sessions_.size(); ++i) {
+    if (nicknames_[i] == sender) {
+      continue;
+    }
+
+    const auto& session = sessions_[i];
+    const Codec codec = session->GetCodec();
+    auto& frame = frames[static_cast<int>(codec)];
+    if (not frame) {
+      frame = std::make_shared<const SimpleMessage>(
+          SimpleMessage::MakeMessage(chat, codec));
+    }
+    if (frame->body_length() == 0) {
+      continue;  // too long for a frame, see ChatBatch::FitsFrame()
+    }
+    session->SendBroadcast(frame, sender);
+  }
+}
+
+void MemberTable::SendChatBatch(const ChatBatch& chat_batch) const {
+  for (size_t i = 0; i < sessions_.size(); ++i) {
+    chat_batch.Send(sessions_[i], nicknames_[i]);
+  }
+}
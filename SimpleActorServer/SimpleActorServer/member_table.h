@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ChatBatch;
+class Session;
+
+//:
+//: room members as parallel arrays, a broadcast walks sessions_ front to
+//: back and writes to every member's session from the calling actor
+//: the index map only serves enter, exit and rename, exit swaps the last
+//: member into the hole so the arrays stay dense
+//: the table holds member sessions until their exit event, which every
+//: session close sends, so a broadcast locks no weak handle per member
+//:
+class MemberTable {
+ public:
+  //: false if session_id is a member already
+  bool Add(const std::string& session_id, const std::string& nickname,
+           const std::shared_ptr<Session>& session);
+  //: false if session_id isn't a member
+  bool Remove(const std::string& session_id);
+  //: false if session_id isn't a member
+  bool Rename(const std::string& session_id, const std::string& nickname);
+
+  //: encoded once per codec in use, the sender doesn't get its own chat
+  void SendChat(const std::string& sender,
+                const std::string& chat_message) const;
+  void SendChatBatch(const ChatBatch& chat_batch) const;
+
+  inline size_t GetSize() const { return sessions_.size(); }
+  inline bool IsEmpty() const { return sessions_.empty(); }
+  inline const std::vector<std::string>& GetSessionIds() const {
+    return session_ids_;
+  }
+  inline const std::vector<std::string>& GetNicknames() const {
+    return nicknames_;
+  }
+  inline const std::vector<std::shared_ptr<Session>>& GetSessions() const {
+    return sessions_;
+  }
+
+ private:
+  std::vector<std::string> session_ids_;
+  std::vector<std::string> nicknames_;
+  std::vector<std::shared_ptr<Session>> sessions_;
+  std::unordered_map<std::string, size_t> indexes_;
+};
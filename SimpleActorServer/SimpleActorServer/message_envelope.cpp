@@ -0,0 +1,203 @@
+#include "message_envelope.h"
+
+#include <cstring>
+#include <limits>
+
+#include "../rapidjson/memorystream.h"
+#include "../rapidjson/reader.h"
+#include "messages.h"
+
+namespace {
+
+const char TYPE_KEY[] = "msg_type";
+const char BODY_KEY[] = "msg_body";
+const unsigned MAX_TYPE =
+    static_cast<unsigned>(std::numeric_limits<int>::max());
+
+const uint8_t BINARY_MARKER = 0x92;  // [msg_type, body]
+
+enum class RootKey {
+  OTHER,
+  TYPE,
+  BODY,
+};
+
+bool IsSeparator(const char c) {
+  return c == ' ' or c == '\t' or c == '\n' or c == '\r' or c == ':';
+}
+
+//:
+//: tracks the nesting depth and only looks at members of the root object
+//: the body span runs from the first byte after "msg_body": to the end of
+//: its value, whatever type that is
+//:
+class EnvelopeHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>,
+                                          EnvelopeHandler> {
+ public:
+  EnvelopeHandler(const rapidjson::MemoryStream& stream, const char* data,
+                  const std::size_t length,
+                  const std::function<bool(const int)>& accept)
+      : stream_(stream),
+        data_(data),
+        length_(length),
+        accept_(accept),
+        depth_(0),
+        key_(RootKey::OTHER),
+        has_type_(false),
+        has_body_(false),
+        rejected_(false),
+        msg_type_(0),
+        body_begin_(0),
+        body_end_(0) {}
+
+  bool Default() { return EndValue(); }
+
+  bool Int(int i) {
+    if (depth_ == 1 and key_ == RootKey::TYPE) {
+      return SetType(i);
+    }
+    return EndValue();
+  }
+  bool Uint(unsigned u) {
+    if (depth_ == 1 and key_ == RootKey::TYPE and u <= MAX_TYPE) {
+      return SetType(static_cast<int>(u));
+    }
+    return EndValue();
+  }
+
+  bool StartObject() {
+    ++depth_;
+    return true;
+  }
+  bool Key(const char* str, rapidjson::SizeType length, bool /*copy*/) {
+    if (depth_ != 1) {
+      return true;
+    }
+    if (length == sizeof(TYPE_KEY) - 1 and
+        std::memcmp(str, TYPE_KEY, length) == 0) {
+      key_ = RootKey::TYPE;
+    } else if (length == sizeof(BODY_KEY) - 1 and
+               std::memcmp(str, BODY_KEY, length) == 0) {
+      key_ = RootKey::BODY;
+      body_begin_ = SkipSeparator(stream_.Tell());
+    } else {
+      key_ = RootKey::OTHER;
+    }
+    return true;
+  }
+  bool EndObject(rapidjson::SizeType /*member_count*/) {
+    --depth_;
+    return EndValue();
+  }
+
+  bool StartArray() {
+    ++depth_;
+    return true;
+  }
+  bool EndArray(rapidjson::SizeType /*element_count*/) {
+    --depth_;
+    return EndValue();
+  }
+
+  bool IsComplete() const { return has_type_ and has_body_; }
+  bool IsRejected() const { return rejected_; }
+  int GetType() const { return msg_type_; }
+  std::size_t GetBodyBegin() const { return body_begin_; }
+  std::size_t GetBodyEnd() const { return body_end_; }
+
+ private:
+  const rapidjson::MemoryStream& stream_;
+  const char* data_;
+  const std::size_t length_;
+  const std::function<bool(const int)>& accept_;
+  int depth_;
+  RootKey key_;
+  bool has_type_;
+  bool has_body_;
+  bool rejected_;
+  int msg_type_;
+  std::size_t body_begin_;
+  std::size_t body_end_;
+
+  bool SetType(const int msg_type) {
+    msg_type_ = msg_type;
+    has_type_ = true;
+    if (not accept_(msg_type)) {
+      rejected_ = true;
+      return false;
+    }
+    return true;
+  }
+
+  //: called whenever a value is complete, at depth 1 that's a root member
+  bool EndValue() {
+    if (depth_ == 1 and key_ == RootKey::BODY) {
+      body_end_ = stream_.Tell();
+      has_body_ = true;
+    }
+    return true;
+  }
+
+  //: the reader has consumed the key, the value follows after ':'
+  std::size_t SkipSeparator(std::size_t pos) const {
+    while (pos < length_ and IsSeparator(data_[pos])) {
+      ++pos;
+    }
+    return pos;
+  }
+};
+
+Envelope::Result ParseBinary(const char* data, const std::size_t length,
+                             const std::function<bool(const int)>& accept,
+                             MessageEnvelope* envelope) {
+  Protocol::Detail::Input in(data, length);
+  uint8_t marker;
+  int msg_type;
+  if (not in.Get(&marker) or marker != BINARY_MARKER or
+      not Protocol::Detail::ReadBinary(&in, &msg_type)) {
+    return Envelope::Result::MALFORMED;
+  }
+  envelope->msg_type = msg_type;
+  if (not accept(msg_type)) {
+    return Envelope::Result::REJECTED;
+  }
+  if (in.IsEnd()) {
+    return Envelope::Result::MALFORMED;
+  }
+
+  envelope->body = in.GetPosition();
+  envelope->body_length = data + length - envelope->body;
+  return Envelope::Result::OK;
+}
+
+}  // namespace
+
+Envelope::Result Envelope::Parse(const char* data, const std::size_t length,
+                                 const std::function<bool(const int)>& accept,
+                                 MessageEnvelope* envelope) {
+  if (length > 0 and static_cast<uint8_t>(data[0]) == BINARY_MARKER) {
+    envelope->codec = Codec::BINARY;
+    return ParseBinary(data, length, accept, envelope);
+  }
+  envelope->codec = Codec::JSON;
+
+  // the reader keeps its stack between frames
+  thread_local rapidjson::Reader reader;
+
+  rapidjson::MemoryStream stream(data, length);
+  EnvelopeHandler handler(stream, data, length, accept);
+  reader.Parse(stream, handler);
+  if (handler.IsRejected()) {
+    envelope->msg_type = handler.GetType();
+    return Result::REJECTED;
+  }
+  if (reader.HasParseError() or not handler.IsComplete()) {
+    return Result::MALFORMED;
+  }
+
+  envelope->msg_type = handler.GetType();
+  envelope->body = data + handler.GetBodyBegin();
+  envelope->body_length = handler.GetBodyEnd() - handler.GetBodyBegin();
+  return Result::OK;
+}
@@ -0,0 +1,1333 @@
+// generated by protocol/generate_messages.py from protocol/messages.json
+// do not edit, change the schema and run the script again
+
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../rapidjson/memorystream.h"
+#include "../rapidjson/reader.h"
+#include "simple_message.h"
+
+namespace Protocol {
+
+namespace Detail {
+
+//:
+//: bounded writer over a caller buffer, Finish() is 0 once anything
+//: didn't fit
+//:
+class Output {
+ public:
+  Output(char* data, const std::size_t capacity)
+      : data_(data), capacity_(capacity), length_(0), overflow_(false) {}
+
+  void Put(const char c) {
+    if (length_ < capacity_) {
+      data_[length_++] = c;
+    } else {
+      overflow_ = true;
+    }
+  }
+  void Put(const char* s, const std::size_t n) {
+    if (capacity_ - length_ >= n) {
+      std::memcpy(data_ + length_, s, n);
+      length_ += n;
+    } else {
+      overflow_ = true;
+    }
+  }
+  std::size_t Finish() const { return overflow_ ? 0 : length_; }
+
+ private:
+  char* data_;
+  const std::size_t capacity_;
+  std::size_t length_;
+  bool overflow_;
+};
+
+class Input {
+ public:
+  Input(const char* data, const std::size_t length)
+      : pos_(reinterpret_cast<const uint8_t*>(data)), end_(pos_ + length) {}
+
+  bool Get(uint8_t* c) {
+    if (pos_ == end_) {
+      return false;
+    }
+    *c = *pos_++;
+    return true;
+  }
+  bool Get(const std::size_t n, uint64_t* v) {
+    if (static_cast<std::size_t>(end_ - pos_) < n) {
+      return false;
+    }
+    *v = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      *v = (*v << 8) | *pos_++;
+    }
+    return true;
+  }
+  bool Get(const std::size_t n, std::string* s) {
+    if (static_cast<std::size_t>(end_ - pos_) < n) {
+      return false;
+    }
+    s->assign(reinterpret_cast<const char*>(pos_), n);
+    pos_ += n;
+    return true;
+  }
+  bool IsEnd() const { return pos_ == end_; }
+  const char* GetPosition() const {
+    return reinterpret_cast<const char*>(pos_);
+  }
+
+ private:
+  const uint8_t* pos_;
+  const uint8_t* const end_;
+};
+
+template <std::size_t N>
+inline bool IsKey(const char* key, const std::size_t length,
+                  const char (&name)[N]) {
+  return length == N - 1 && std::memcmp(key, name, N - 1) == 0;
+}
+
+#pragma region json
+inline void WriteJson(Output* out, const int value) {
+  char digits[12];
+  std::size_t n = 0;
+  unsigned magnitude = (value < 0) ? 0u - static_cast<unsigned>(value)
+                                   : static_cast<unsigned>(value);
+  do {
+    digits[n++] = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) {
+    out->Put('-');
+  }
+  while (n > 0) {
+    out->Put(digits[--n]);
+  }
+}
+
+inline char GetEscape(const unsigned char c) {
+  switch (c) {
+    case '"':
+      return '"';
+    case '\\':
+      return '\\';
+    case '\b':
+      return 'b';
+    case '\f':
+      return 'f';
+    case '\n':
+      return 'n';
+    case '\r':
+      return 'r';
+    case '\t':
+      return 't';
+    default:
+      return (c < 0x20) ? 'u' : 0;
+  }
+}
+
+//: escapes like rapidjson::Writer, so both encoders give the same bytes
+inline void WriteJson(Output* out, const std::string& value) {
+  static const char HEX[] = "0123456789ABCDEF";
+  out->Put('"');
+  const char* begin = value.data();
+  const char* const end = begin + value.size();
+  for (const char* p = begin; p != end; ++p) {
+    const unsigned char c = static_cast<unsigned char>(*p);
+    const char escape = GetEscape(c);
+    if (escape == 0) {
+      continue;
+    }
+    out->Put(begin, p - begin);
+    begin = p + 1;
+    out->Put('\\');
+    out->Put(escape);
+    if (escape == 'u') {
+      const char code[4] = {'0', '0', HEX[c >> 4], HEX[c & 0xf]};
+      out->Put(code, sizeof(code));
+    }
+  }
+  out->Put(begin, end - begin);
+  out->Put('"');
+}
+
+inline void WriteJson(Output* out, const std::vector<std::string>& values) {
+  out->Put('[');
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    if (i != 0) {
+      out->Put(',');
+    }
+    WriteJson(out, values[i]);
+  }
+  out->Put(']');
+}
+
+//:
+//: SAX handler filling T from the members of the root object
+//: the key is resolved to a field index as soon as it's read, since the
+//: reader reuses the key's memory for the value
+//: a list field is an array of strings directly under its key
+//:
+template <typename T>
+class JsonHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JsonHandler<T>> {
+ public:
+  explicit JsonHandler(T* msg)
+      : msg_(msg),
+        depth_(0),
+        field_(-1),
+        is_object_(false),
+        is_list_(false),
+        seen_(0) {}
+
+  bool Default() { return true; }
+  bool Int(int i) {
+    if (depth_ == 1 && msg_->SetField(field_, i)) {
+      seen_ |= 1u << field_;
+    }
+    return true;
+  }
+  bool Uint(unsigned u) {
+    return (u <= static_cast<unsigned>(INT_MAX)) ? Int(static_cast<int>(u))
+                                                 : true;
+  }
+  bool String(const char* str, rapidjson::SizeType length, bool /*copy*/) {
+    if (depth_ == 1 && msg_->SetField(field_, str, length)) {
+      seen_ |= 1u << field_;
+    } else if (depth_ == 2 && is_list_) {
+      msg_->AddField(field_, str, length);
+    }
+    return true;
+  }
+  bool StartObject() {
+    is_object_ = is_object_ || depth_ == 0;
+    ++depth_;
+    return true;
+  }
+  bool Key(const char* str, rapidjson::SizeType length, bool /*copy*/) {
+    if (depth_ == 1) {
+      field_ = T::FindField(str, length);
+    }
+    return true;
+  }
+  bool EndObject(rapidjson::SizeType /*member_count*/) {
+    --depth_;
+    return true;
+  }
+  bool StartArray() {
+    if (depth_ == 1 && msg_->StartList(field_)) {
+      seen_ |= 1u << field_;
+      is_list_ = true;
+    }
+    ++depth_;
+    return true;
+  }
+  bool EndArray(rapidjson::SizeType /*element_count*/) {
+    --depth_;
+    if (depth_ == 1) {
+      is_list_ = false;
+    }
+    return true;
+  }
+
+  //: every field has to be there
+  bool IsComplete() const {
+    return is_object_ && seen_ == (1u << T::FIELD_COUNT) - 1;
+  }
+
+ private:
+  T* msg_;
+  int depth_;
+  int field_;
+  bool is_object_;
+  bool is_list_;
+  uint32_t seen_;
+};
+
+template <typename T>
+inline bool DecodeJson(const char* data, const std::size_t length, T* msg) {
+  // the reader keeps its stack between messages
+  thread_local rapidjson::Reader reader;
+  rapidjson::MemoryStream stream(data, length);
+  JsonHandler<T> handler(msg);
+  return !reader.Parse(stream, handler).IsError() && handler.IsComplete();
+}
+#pragma endregion
+
+#pragma region binary
+//: MessagePack, small values take the short forms
+inline void WriteBinary(Output* out, const int value) {
+  if (value >= 0 && value <= 0x7f) {
+    out->Put(static_cast<char>(value));
+  } else if (value < 0 && value >= -32) {
+    out->Put(static_cast<char>(0xe0 | (value + 32)));
+  } else if (value >= 0 && value <= 0xffff) {
+    const uint8_t marker = (value <= 0xff) ? 0xcc : 0xcd;
+    const std::size_t n = (value <= 0xff) ? 1 : 2;
+    out->Put(static_cast<char>(marker));
+    for (std::size_t i = n; i > 0; --i) {
+      out->Put(static_cast<char>(value >> ((i - 1) * 8)));
+    }
+  } else {
+    const uint32_t bits = static_cast<uint32_t>(value);
+    out->Put(static_cast<char>(value >= 0 ? 0xce : 0xd2));
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out->Put(static_cast<char>(bits >> shift));
+    }
+  }
+}
+
+inline void WriteBinary(Output* out, const std::string& value) {
+  const std::size_t n = value.size();
+  if (n < 32) {
+    out->Put(static_cast<char>(0xa0 | n));
+  } else if (n <= 0xff) {
+    out->Put(static_cast<char>(0xd9));
+    out->Put(static_cast<char>(n));
+  } else if (n <= 0xffff) {
+    out->Put(static_cast<char>(0xda));
+    out->Put(static_cast<char>(n >> 8));
+    out->Put(static_cast<char>(n));
+  } else {
+    out->Put(static_cast<char>(0xdb));
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out->Put(static_cast<char>(n >> shift));
+    }
+  }
+  out->Put(value.data(), n);
+}
+
+inline void WriteBinary(Output* out, const std::vector<std::string>& values) {
+  const std::size_t n = values.size();
+  if (n <= 15) {
+    out->Put(static_cast<char>(0x90 | n));
+  } else if (n <= 0xffff) {
+    out->Put(static_cast<char>(0xdc));
+    out->Put(static_cast<char>(n >> 8));
+    out->Put(static_cast<char>(n));
+  } else {
+    out->Put(static_cast<char>(0xdd));
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out->Put(static_cast<char>(n >> shift));
+    }
+  }
+  for (const auto& value : values) {
+    WriteBinary(out, value);
+  }
+}
+
+inline bool ReadBinary(Input* in, int* value) {
+  uint8_t marker;
+  if (!in->Get(&marker)) {
+    return false;
+  }
+  if (marker <= 0x7f) {
+    *value = marker;
+    return true;
+  }
+  if (marker >= 0xe0) {
+    *value = static_cast<int8_t>(marker);
+    return true;
+  }
+  uint64_t bits;
+  switch (marker) {
+    case 0xcc:
+    case 0xcd:
+    case 0xce: {
+      const std::size_t n = std::size_t(1) << (marker - 0xcc);
+      if (!in->Get(n, &bits) || bits > static_cast<uint64_t>(INT_MAX)) {
+        return false;
+      }
+      *value = static_cast<int>(bits);
+      return true;
+    }
+    case 0xd0:
+    case 0xd1:
+    case 0xd2: {
+      const std::size_t n = std::size_t(1) << (marker - 0xd0);
+      if (!in->Get(n, &bits)) {
+        return false;
+      }
+      // sign extend from n bytes
+      const uint64_t sign = uint64_t(1) << (n * 8 - 1);
+      *value = static_cast<int>(static_cast<int64_t>((bits ^ sign) - sign));
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+inline bool ReadBinary(Input* in, std::string* value) {
+  uint8_t marker;
+  if (!in->Get(&marker)) {
+    return false;
+  }
+  uint64_t n;
+  if ((marker & 0xe0) == 0xa0) {
+    n = marker & 0x1f;
+  } else if (marker >= 0xd9 && marker <= 0xdb) {
+    if (!in->Get(std::size_t(1) << (marker - 0xd9), &n)) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  return in->Get(static_cast<std::size_t>(n), value);
+}
+
+inline bool ReadBinary(Input* in, std::vector<std::string>* values) {
+  uint8_t marker;
+  if (!in->Get(&marker)) {
+    return false;
+  }
+  uint64_t n;
+  if ((marker & 0xf0) == 0x90) {
+    n = marker & 0x0f;
+  } else if (marker == 0xdc || marker == 0xdd) {
+    if (!in->Get(std::size_t(2) << (marker - 0xdc), &n)) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  values->clear();
+  for (uint64_t i = 0; i < n; ++i) {
+    // every string takes a byte at least, a bogus count runs out first
+    values->emplace_back();
+    if (!ReadBinary(in, &values->back())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline bool ReadBinaryArray(Input* in, const int field_count) {
+  uint8_t marker;
+  return in->Get(&marker) && marker == (0x90 | field_count);
+}
+
+template <typename T>
+inline bool DecodeBinary(const char* data, const std::size_t length, T* msg) {
+  Input in(data, length);
+  return ReadBinaryArray(&in, T::FIELD_COUNT) && msg->ReadBinary(&in) &&
+         in.IsEnd();
+}
+#pragma endregion
+
+template <typename T, typename Encoder>
+inline std::size_t Encode(const T& msg, char* data, const std::size_t capacity,
+                          Encoder encoder) {
+  Output out(data, capacity);
+  (msg.*encoder)(&out);
+  return out.Finish();
+}
+
+}  // namespace Detail
+
+//:
+//: client -> server, sets the nickname of the session
+//:
+struct Register {
+  static constexpr MessageType TYPE = MessageType::Register;
+  enum { FIELD_COUNT = 1 };
+
+  std::string nickname;
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &Register::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &Register::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    if (Detail::IsKey(key, length, "nickname")) {
+      return 0;
+    }
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    (void)field;
+    (void)value;
+    return false;
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    switch (field) {
+      case 0:
+        nickname.assign(value, length);
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{\"nickname\":", 12);
+    Detail::WriteJson(out, nickname);
+    out->Put('}');
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+    Detail::WriteBinary(out, nickname);
+  }
+  bool ReadBinary(Detail::Input* in) {
+    return Detail::ReadBinary(in, &nickname);
+  }
+};
+
+//:
+//: server -> client
+//:
+struct RegisterAck {
+  static constexpr MessageType TYPE = MessageType::RegisterAck;
+  enum { FIELD_COUNT = 1 };
+
+  int result = 0;
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &RegisterAck::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &RegisterAck::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    if (Detail::IsKey(key, length, "result")) {
+      return 0;
+    }
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    switch (field) {
+      case 0:
+        result = value;
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{\"result\":", 10);
+    Detail::WriteJson(out, result);
+    out->Put('}');
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+    Detail::WriteBinary(out, result);
+  }
+  bool ReadBinary(Detail::Input* in) {
+    return Detail::ReadBinary(in, &result);
+  }
+};
+
+//:
+//: client -> server, joins a room picked by the server
+//:
+struct EnterRoom {
+  static constexpr MessageType TYPE = MessageType::EnterRoom;
+  enum { FIELD_COUNT = 0 };
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &EnterRoom::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &EnterRoom::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    (void)key;
+    (void)length;
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    (void)field;
+    (void)value;
+    return false;
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{}", 2);
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+  }
+  bool ReadBinary(Detail::Input* in) {
+    (void)in;
+    return true;
+  }
+};
+
+//:
+//: server -> client
+//:
+struct EnterRoomAck {
+  static constexpr MessageType TYPE = MessageType::EnterRoomAck;
+  enum { FIELD_COUNT = 1 };
+
+  int result = 0;
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &EnterRoomAck::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &EnterRoomAck::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    if (Detail::IsKey(key, length, "result")) {
+      return 0;
+    }
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    switch (field) {
+      case 0:
+        result = value;
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{\"result\":", 10);
+    Detail::WriteJson(out, result);
+    out->Put('}');
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+    Detail::WriteBinary(out, result);
+  }
+  bool ReadBinary(Detail::Input* in) {
+    return Detail::ReadBinary(in, &result);
+  }
+};
+
+//:
+//: client -> server
+//:
+struct ExitRoom {
+  static constexpr MessageType TYPE = MessageType::ExitRoom;
+  enum { FIELD_COUNT = 0 };
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &ExitRoom::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &ExitRoom::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    (void)key;
+    (void)length;
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    (void)field;
+    (void)value;
+    return false;
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{}", 2);
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+  }
+  bool ReadBinary(Detail::Input* in) {
+    (void)in;
+    return true;
+  }
+};
+
+//:
+//: server -> client
+//:
+struct ExitRoomAck {
+  static constexpr MessageType TYPE = MessageType::ExitRoomAck;
+  enum { FIELD_COUNT = 1 };
+
+  int result = 0;
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &ExitRoomAck::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &ExitRoomAck::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    if (Detail::IsKey(key, length, "result")) {
+      return 0;
+    }
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    switch (field) {
+      case 0:
+        result = value;
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{\"result\":", 10);
+    Detail::WriteJson(out, result);
+    out->Put('}');
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+    Detail::WriteBinary(out, result);
+  }
+  bool ReadBinary(Detail::Input* in) {
+    return Detail::ReadBinary(in, &result);
+  }
+};
+
+//:
+//: client -> server, broadcast to the rest of the room
+//:
+struct SendChat {
+  static constexpr MessageType TYPE = MessageType::SendChat;
+  enum { FIELD_COUNT = 1 };
+
+  std::string chat_message;
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &SendChat::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &SendChat::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    if (Detail::IsKey(key, length, "chat_message")) {
+      return 0;
+    }
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    (void)field;
+    (void)value;
+    return false;
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    switch (field) {
+      case 0:
+        chat_message.assign(value, length);
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{\"chat_message\":", 16);
+    Detail::WriteJson(out, chat_message);
+    out->Put('}');
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+    Detail::WriteBinary(out, chat_message);
+  }
+  bool ReadBinary(Detail::Input* in) {
+    return Detail::ReadBinary(in, &chat_message);
+  }
+};
+
+//:
+//: server -> client
+//:
+struct SendChatAck {
+  static constexpr MessageType TYPE = MessageType::SendChatAck;
+  enum { FIELD_COUNT = 1 };
+
+  int result = 0;
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &SendChatAck::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &SendChatAck::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    if (Detail::IsKey(key, length, "result")) {
+      return 0;
+    }
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    switch (field) {
+      case 0:
+        result = value;
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{\"result\":", 10);
+    Detail::WriteJson(out, result);
+    out->Put('}');
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+    Detail::WriteBinary(out, result);
+  }
+  bool ReadBinary(Detail::Input* in) {
+    return Detail::ReadBinary(in, &result);
+  }
+};
+
+//:
+//: server -> every other member of the sender's room
+//:
+struct BroadcastingChat {
+  static constexpr MessageType TYPE = MessageType::BroadcastingChat;
+  enum { FIELD_COUNT = 3 };
+
+  int result = 0;
+  std::string sender;
+  std::string chat_message;
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &BroadcastingChat::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &BroadcastingChat::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    if (Detail::IsKey(key, length, "result")) {
+      return 0;
+    }
+    if (Detail::IsKey(key, length, "sender")) {
+      return 1;
+    }
+    if (Detail::IsKey(key, length, "chat_message")) {
+      return 2;
+    }
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    switch (field) {
+      case 0:
+        result = value;
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    switch (field) {
+      case 1:
+        sender.assign(value, length);
+        return true;
+      case 2:
+        chat_message.assign(value, length);
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{\"result\":", 10);
+    Detail::WriteJson(out, result);
+    out->Put(",\"sender\":", 10);
+    Detail::WriteJson(out, sender);
+    out->Put(",\"chat_message\":", 16);
+    Detail::WriteJson(out, chat_message);
+    out->Put('}');
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+    Detail::WriteBinary(out, result);
+    Detail::WriteBinary(out, sender);
+    Detail::WriteBinary(out, chat_message);
+  }
+  bool ReadBinary(Detail::Input* in) {
+    return Detail::ReadBinary(in, &result) &&
+           Detail::ReadBinary(in, &sender) &&
+           Detail::ReadBinary(in, &chat_message);
+  }
+};
+
+//:
+//: client -> server, asks for the codec the server sends with
+//:
+struct Hello {
+  static constexpr MessageType TYPE = MessageType::Hello;
+  enum { FIELD_COUNT = 1 };
+
+  int codec = 0;
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &Hello::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &Hello::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    if (Detail::IsKey(key, length, "codec")) {
+      return 0;
+    }
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    switch (field) {
+      case 0:
+        codec = value;
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{\"codec\":", 9);
+    Detail::WriteJson(out, codec);
+    out->Put('}');
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+    Detail::WriteBinary(out, codec);
+  }
+  bool ReadBinary(Detail::Input* in) {
+    return Detail::ReadBinary(in, &codec);
+  }
+};
+
+//:
+//: server -> client, in the old codec, the chosen one follows
+//:
+struct HelloAck {
+  static constexpr MessageType TYPE = MessageType::HelloAck;
+  enum { FIELD_COUNT = 2 };
+
+  int result = 0;
+  int codec = 0;
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &HelloAck::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &HelloAck::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    if (Detail::IsKey(key, length, "result")) {
+      return 0;
+    }
+    if (Detail::IsKey(key, length, "codec")) {
+      return 1;
+    }
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    switch (field) {
+      case 0:
+        result = value;
+        return true;
+      case 1:
+        codec = value;
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  bool StartList(const int field) {
+    (void)field;
+    return false;
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{\"result\":", 10);
+    Detail::WriteJson(out, result);
+    out->Put(",\"codec\":", 9);
+    Detail::WriteJson(out, codec);
+    out->Put('}');
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+    Detail::WriteBinary(out, result);
+    Detail::WriteBinary(out, codec);
+  }
+  bool ReadBinary(Detail::Input* in) {
+    return Detail::ReadBinary(in, &result) &&
+           Detail::ReadBinary(in, &codec);
+  }
+};
+
+//:
+//: server -> member, chats of one batching window, line i by senders[i]
+//:
+struct BroadcastingChatBatch {
+  static constexpr MessageType TYPE = MessageType::BroadcastingChatBatch;
+  enum { FIELD_COUNT = 3 };
+
+  int result = 0;
+  std::vector<std::string> senders;
+  std::vector<std::string> chat_messages;
+
+  bool DecodeJson(const char* data, const std::size_t length) {
+    return Detail::DecodeJson(data, length, this);
+  }
+  std::size_t EncodeJson(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &BroadcastingChatBatch::WriteJson);
+  }
+  bool DecodeBinary(const char* data, const std::size_t length) {
+    return Detail::DecodeBinary(data, length, this);
+  }
+  std::size_t EncodeBinary(char* data, const std::size_t capacity) const {
+    return Detail::Encode(*this, data, capacity,
+                          &BroadcastingChatBatch::WriteBinary);
+  }
+
+  static int FindField(const char* key, const std::size_t length) {
+    if (Detail::IsKey(key, length, "result")) {
+      return 0;
+    }
+    if (Detail::IsKey(key, length, "senders")) {
+      return 1;
+    }
+    if (Detail::IsKey(key, length, "chat_messages")) {
+      return 2;
+    }
+    return -1;
+  }
+  bool SetField(const int field, const int value) {
+    switch (field) {
+      case 0:
+        result = value;
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool SetField(const int field, const char* value,
+                const std::size_t length) {
+    (void)field;
+    (void)value;
+    (void)length;
+    return false;
+  }
+  bool StartList(const int field) {
+    switch (field) {
+      case 1:
+        senders.clear();
+        return true;
+      case 2:
+        chat_messages.clear();
+        return true;
+      default:
+        return false;
+    }
+  }
+  bool AddField(const int field, const char* value,
+                const std::size_t length) {
+    switch (field) {
+      case 1:
+        senders.emplace_back(value, length);
+        return true;
+      case 2:
+        chat_messages.emplace_back(value, length);
+        return true;
+      default:
+        return false;
+    }
+  }
+  void WriteJson(Detail::Output* out) const {
+    out->Put("{\"result\":", 10);
+    Detail::WriteJson(out, result);
+    out->Put(",\"senders\":", 11);
+    Detail::WriteJson(out, senders);
+    out->Put(",\"chat_messages\":", 17);
+    Detail::WriteJson(out, chat_messages);
+    out->Put('}');
+  }
+  void WriteBinary(Detail::Output* out) const {
+    out->Put(static_cast<char>(0x90 | FIELD_COUNT));
+    Detail::WriteBinary(out, result);
+    Detail::WriteBinary(out, senders);
+    Detail::WriteBinary(out, chat_messages);
+  }
+  bool ReadBinary(Detail::Input* in) {
+    return Detail::ReadBinary(in, &result) &&
+           Detail::ReadBinary(in, &senders) &&
+           Detail::ReadBinary(in, &chat_messages);
+  }
+};
+
+}  // namespace Protocol
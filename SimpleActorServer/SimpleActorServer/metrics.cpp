@@ -0,0 +1,324 @@
+#include "metrics.h"
+
+#include <boost/lexical_cast.hpp>
+
+#include "network_utility.h"
+#include "room_manager.h"
+#include "thread_pool_manager.h"
+
+namespace {
+
+Counter bytes_in;
+Counter bytes_out;
+Counter frames_in;
+Counter frames_out;
+Counter rejected_messages;
+Counter outbound_dropped;
+Counter outbound_coalesced;
+Counter outbound_disconnects;
+Counter messages_in[Metrics::MAX_MESSAGE_TYPE];
+Counter messages_out[Metrics::MAX_MESSAGE_TYPE];
+
+Counter tasks;
+Counter mailbox_overloads;
+Counter read_pauses;
+Histogram task_duration_msec{0, 1, 2, 5, 10, 25, 50, 100, 250, 500, 1000};
+
+Gauge pending_timers;
+Counter fired_timers;
+
+Counter watchdog_long_tasks;
+Counter watchdog_backlogs;
+Counter watchdog_suppressed;
+
+const int TRACE_STAGE_COUNT = static_cast<int>(TraceStage::COUNT);
+std::unique_ptr<Histogram>
+    trace_stage_usec[Metrics::MAX_MESSAGE_TYPE][TRACE_STAGE_COUNT];
+
+bool InitializeTraceHistograms() {
+  for (auto& stages : trace_stage_usec) {
+    for (auto& histogram : stages) {
+      histogram.reset(new Histogram{10, 50, 100, 250, 500, 1000, 2500, 5000,
+                                    10000, 25000, 50000, 100000, 250000,
+                                    1000000});
+    }
+  }
+  return true;
+}
+
+const bool trace_histograms_initialized = InitializeTraceHistograms();
+
+inline bool IsValidMessageType(const int msg_type) {
+  return msg_type >= 0 and msg_type < Metrics::MAX_MESSAGE_TYPE;
+}
+
+void RenderHeader(const std::string& name, const std::string& type,
+                  const std::string& help, std::string* out) {
+  *out += "# HELP " + name + " " + help + "\n";
+  *out += "# TYPE " + name + " " + type + "\n";
+}
+
+template <typename T>
+void RenderSample(const std::string& name, const std::string& labels,
+                  const T value, std::string* out) {
+  *out += name;
+  if (not labels.empty()) {
+    *out += "{" + labels + "}";
+  }
+  *out += " " + boost::lexical_cast<std::string>(value) + "\n";
+}
+
+void RenderTraceStages(std::string* out) {
+  const std::string name = "simple_actor_trace_stage_us";
+  RenderHeader(name, "histogram",
+               "Sampled per-stage latency by originating message type.", out);
+  for (int i = 0; i < Metrics::MAX_MESSAGE_TYPE; ++i) {
+    for (int stage = 0; stage < TRACE_STAGE_COUNT; ++stage) {
+      const auto& histogram = trace_stage_usec[i][stage];
+      if (histogram->Count() == 0) {
+        continue;
+      }
+      const std::string labels =
+          "msg_type=\"" + std::to_string(i) + "\",stage=\"" +
+          Trace::GetStageName(static_cast<TraceStage>(stage)) + "\"";
+      histogram->Render(name, labels, out);
+    }
+  }
+}
+
+void RenderMessageCounters(const std::string& name, const std::string& help,
+                           const Counter* counters, std::string* out) {
+  RenderHeader(name, "counter", help, out);
+  for (int i = 0; i < Metrics::MAX_MESSAGE_TYPE; ++i) {
+    const uint64_t value = counters[i].Value();
+    if (value == 0) {
+      continue;
+    }
+    RenderSample(name, "msg_type=\"" + std::to_string(i) + "\"", value, out);
+  }
+}
+
+}  // namespace
+
+Histogram::Histogram(std::initializer_list<uint64_t> bounds)
+    : bounds_(bounds),
+      buckets_(new std::atomic<uint64_t>[bounds.size() + 1]),
+      sum_(0) {
+  for (size_t i = 0; i <= bounds_.size(); ++i) {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void Histogram::Observe(const uint64_t v) {
+  size_t i = 0;
+  while (i < bounds_.size() and v > bounds_[i]) {
+    ++i;
+  }
+  buckets_[i].fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(v, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::Count() const {
+  uint64_t count = 0;
+  for (size_t i = 0; i <= bounds_.size(); ++i) {
+    count += buckets_[i].load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+void Histogram::Render(const std::string& name, const std::string& labels,
+                       std::string* out) const {
+  const std::string prefix = labels.empty() ? "" : labels + ",";
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < bounds_.size(); ++i) {
+    cumulative += buckets_[i].load(std::memory_order_relaxed);
+    RenderSample(name + "_bucket",
+                 prefix + "le=\"" + std::to_string(bounds_[i]) + "\"",
+                 cumulative, out);
+  }
+  cumulative += buckets_[bounds_.size()].load(std::memory_order_relaxed);
+  RenderSample(name + "_bucket", prefix + "le=\"+Inf\"", cumulative, out);
+  RenderSample(name + "_sum", labels, sum_.load(std::memory_order_relaxed),
+               out);
+  RenderSample(name + "_count", labels, cumulative, out);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+void Metrics::AddInboundFrame(const size_t bytes) {
+  frames_in.Increment();
+  bytes_in.Increment(bytes);
+}
+
+void Metrics::AddOutboundFrame(const size_t bytes) {
+  frames_out.Increment();
+  bytes_out.Increment(bytes);
+}
+
+void Metrics::AddInboundMessage(const int msg_type) {
+  if (IsValidMessageType(msg_type)) {
+    messages_in[msg_type].Increment();
+  }
+}
+
+void Metrics::AddOutboundMessage(const int msg_type) {
+  if (IsValidMessageType(msg_type)) {
+    messages_out[msg_type].Increment();
+  }
+}
+
+void Metrics::AddRejectedMessage() { rejected_messages.Increment(); }
+
+void Metrics::AddOutboundDropped() { outbound_dropped.Increment(); }
+
+void Metrics::AddOutboundCoalesced() { outbound_coalesced.Increment(); }
+
+void Metrics::AddOutboundDisconnect() { outbound_disconnects.Increment(); }
+
+void Metrics::ObserveTask(const uint64_t elapsed_msec) {
+  tasks.Increment();
+  task_duration_msec.Observe(elapsed_msec);
+}
+
+void Metrics::AddMailboxOverload() { mailbox_overloads.Increment(); }
+
+void Metrics::AddReadPause() { read_pauses.Increment(); }
+
+void Metrics::AddPendingTimer(const int64_t delta) {
+  pending_timers.Add(delta);
+}
+
+void Metrics::AddFiredTimer(const uint64_t count) {
+  fired_timers.Increment(count);
+}
+
+void Metrics::AddWatchdogReport(const bool is_long_task) {
+  if (is_long_task) {
+    watchdog_long_tasks.Increment();
+  } else {
+    watchdog_backlogs.Increment();
+  }
+}
+
+void Metrics::AddWatchdogSuppressed(const uint64_t count) {
+  watchdog_suppressed.Increment(count);
+}
+
+void Metrics::ObserveTraceStage(const int msg_type, const TraceStage stage,
+                                const int64_t elapsed_usec) {
+  if (IsValidMessageType(msg_type)) {
+    trace_stage_usec[msg_type][static_cast<int>(stage)]->Observe(
+        elapsed_usec > 0 ? elapsed_usec : 0);
+  }
+}
+
+std::string Metrics::Render() {
+  std::string out;
+  out.reserve(8192);
+
+  RenderHeader("simple_actor_connections", "gauge", "Open client sessions.",
+               &out);
+  RenderSample("simple_actor_connections", "",
+               Connection::GetCunnectionCount(), &out);
+
+  RenderHeader("simple_actor_bytes_received_total", "counter",
+               "Bytes read from client sockets.", &out);
+  RenderSample("simple_actor_bytes_received_total", "", bytes_in.Value(), &out);
+  RenderHeader("simple_actor_bytes_sent_total", "counter",
+               "Bytes written to client sockets.", &out);
+  RenderSample("simple_actor_bytes_sent_total", "", bytes_out.Value(), &out);
+  RenderHeader("simple_actor_frames_received_total", "counter",
+               "Frames read from client sockets.", &out);
+  RenderSample("simple_actor_frames_received_total", "", frames_in.Value(),
+               &out);
+  RenderHeader("simple_actor_frames_sent_total", "counter",
+               "Frames written to client sockets.", &out);
+  RenderSample("simple_actor_frames_sent_total", "", frames_out.Value(), &out);
+
+  RenderMessageCounters("simple_actor_messages_received_total",
+                        "Dispatched inbound messages by type.", messages_in,
+                        &out);
+  RenderMessageCounters("simple_actor_messages_sent_total",
+                        "Written outbound messages by type.", messages_out,
+                        &out);
+  RenderHeader("simple_actor_messages_rejected_total", "counter",
+               "Inbound frames dropped before dispatch.", &out);
+  RenderSample("simple_actor_messages_rejected_total", "",
+               rejected_messages.Value(), &out);
+
+  RenderHeader("simple_actor_outbound_policy_total", "counter",
+               "Slow consumer policy actions: broadcast frames dropped or "
+               "coalesced, sessions disconnected.",
+               &out);
+  RenderSample("simple_actor_outbound_policy_total", "action=\"drop_oldest\"",
+               outbound_dropped.Value(), &out);
+  RenderSample("simple_actor_outbound_policy_total", "action=\"coalesce\"",
+               outbound_coalesced.Value(), &out);
+  RenderSample("simple_actor_outbound_policy_total", "action=\"disconnect\"",
+               outbound_disconnects.Value(), &out);
+
+  RenderHeader("simple_actor_pool_queue_depth", "gauge",
+               "Tasks waiting in the thread pool queue.", &out);
+  RenderSample("simple_actor_pool_queue_depth", "",
+               ThreadPoolManager::GetInstance()->GetQueueSize(), &out);
+  const auto activations =
+      ThreadPoolManager::GetInstance()->GetActivationStatus();
+  RenderHeader("simple_actor_pool_activations_total", "counter",
+               "Actor activations on or off their home worker.", &out);
+  RenderSample("simple_actor_pool_activations_total", "placement=\"local\"",
+               activations.local, &out);
+  RenderSample("simple_actor_pool_activations_total",
+               "placement=\"migrated\"", activations.migrated, &out);
+  RenderHeader("simple_actor_pool_tasks_total", "counter",
+               "Tasks executed by the thread pool.", &out);
+  RenderSample("simple_actor_pool_tasks_total", "", tasks.Value(), &out);
+  RenderHeader("simple_actor_pool_task_duration_ms", "histogram",
+               "Thread pool task execution time.", &out);
+  task_duration_msec.Render("simple_actor_pool_task_duration_ms", "", &out);
+
+  RenderHeader("simple_actor_mailbox_overloads_total", "counter",
+               "Actor mailboxes that reached the high watermark.", &out);
+  RenderSample("simple_actor_mailbox_overloads_total", "",
+               mailbox_overloads.Value(), &out);
+  RenderHeader("simple_actor_session_read_pauses_total", "counter",
+               "Session reads held until an overloaded mailbox drained.",
+               &out);
+  RenderSample("simple_actor_session_read_pauses_total", "",
+               read_pauses.Value(), &out);
+
+  RenderHeader("simple_actor_timer_events_pending", "gauge",
+               "Delayed events waiting for their deadline.", &out);
+  RenderSample("simple_actor_timer_events_pending", "", pending_timers.Value(),
+               &out);
+  RenderHeader("simple_actor_timer_events_fired_total", "counter",
+               "Delayed events handed to their actor.", &out);
+  RenderSample("simple_actor_timer_events_fired_total", "",
+               fired_timers.Value(), &out);
+
+  Histogram room_members{0, 1, 2, 5, 10, 50, 100, 500, 1000, 5000, 10000};
+  const auto member_counts = RoomManager::GetRoomMemberCounts();
+  for (const size_t count : member_counts) {
+    room_members.Observe(count);
+  }
+  RenderHeader("simple_actor_rooms", "gauge", "Open rooms.", &out);
+  RenderSample("simple_actor_rooms", "", member_counts.size(), &out);
+  RenderHeader("simple_actor_room_members", "histogram",
+               "Member count distribution over open rooms.", &out);
+  room_members.Render("simple_actor_room_members", "", &out);
+
+  RenderHeader("simple_actor_watchdog_reports_total", "counter",
+               "Stuck actors and long tasks reported by the watchdog.", &out);
+  RenderSample("simple_actor_watchdog_reports_total", "kind=\"long_task\"",
+               watchdog_long_tasks.Value(), &out);
+  RenderSample("simple_actor_watchdog_reports_total", "kind=\"backlog\"",
+               watchdog_backlogs.Value(), &out);
+  RenderHeader("simple_actor_watchdog_suppressed_total", "counter",
+               "Watchdog reports dropped by rate limiting.", &out);
+  RenderSample("simple_actor_watchdog_suppressed_total", "",
+               watchdog_suppressed.Value(), &out);
+
+  RenderTraceStages(&out);
+
+  return out;
+}
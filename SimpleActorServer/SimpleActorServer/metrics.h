@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "trace_context.h"
+
+//:
+//: monotonic counter (relaxed atomic)
+//:
+class Counter {
+ public:
+  Counter() : value_(0) {}
+
+  inline void Increment(const uint64_t v = 1) {
+    value_.fetch_add(v, std::memory_order_relaxed);
+  }
+  inline uint64_t Value() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<uint64_t> value_;
+};
+
+//:
+//: up/down gauge (relaxed atomic)
+//:
+class Gauge {
+ public:
+  Gauge() : value_(0) {}
+
+  inline void Add(const int64_t v) {
+    value_.fetch_add(v, std::memory_order_relaxed);
+  }
+  inline void Set(const int64_t v) {
+    value_.store(v, std::memory_order_relaxed);
+  }
+  inline int64_t Value() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t> value_;
+};
+
+//:
+//: fixed bucket histogram
+//: bucket upper bounds are inclusive, last bucket is +Inf
+//:
+class Histogram {
+ public:
+  Histogram(std::initializer_list<uint64_t> bounds);
+
+  void Observe(const uint64_t v);
+  uint64_t Count() const;
+  void Render(const std::string& name, const std::string& labels,
+              std::string* out) const;
+
+ private:
+  const std::vector<uint64_t> bounds_;
+  std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+  std::atomic<uint64_t> sum_;
+};
+
+//:
+//: process wide metrics, exported in prometheus text format
+//:
+namespace Metrics {
+
+const int MAX_MESSAGE_TYPE = 128;
+
+void AddInboundFrame(const size_t bytes);
+void AddOutboundFrame(const size_t bytes);
+void AddInboundMessage(const int msg_type);
+void AddOutboundMessage(const int msg_type);
+void AddRejectedMessage();
+
+void ObserveTask(const uint64_t elapsed_msec);
+void AddMailboxOverload();
+void AddReadPause();
+void AddOutboundDropped();
+void AddOutboundCoalesced();
+void AddOutboundDisconnect();
+void AddPendingTimer(const int64_t delta);
+void AddFiredTimer(const uint64_t count);
+
+void AddWatchdogReport(const bool is_long_task);
+void AddWatchdogSuppressed(const uint64_t count);
+
+void ObserveTraceStage(const int msg_type, const TraceStage stage,
+                       const int64_t elapsed_usec);
+
+std::string Render();
+
+}  // namespace Metrics
@@ -0,0 +1,130 @@
+#include "metrics_listener.h"
+
+#include <memory>
+#include <string>
+
+#include "logger.h"
+#include "metrics.h"
+#include "utility.h"
+
+namespace {
+
+const size_t MAX_REQUEST_HEADER_SIZE = 8192;
+
+//:
+//: one request per connection, answered with Connection: close
+//:
+class MetricsHttpSession
+    : public std::enable_shared_from_this<MetricsHttpSession> {
+ public:
+  MetricsHttpSession(boost::asio::ip::tcp::socket&& socket)
+      : socket_(std::move(socket)), request_(MAX_REQUEST_HEADER_SIZE) {}
+
+  void Start() { DoReadRequest(); }
+
+ private:
+  boost::asio::ip::tcp::socket socket_;
+  boost::asio::streambuf request_;
+  std::string response_;
+
+  void DoReadRequest() {
+    auto self(shared_from_this());
+    boost::asio::async_read_until(
+        socket_, request_, "\r\n\r\n",
+        [this, self](boost::system::error_code ec, std::size_t length) {
+          if (ec) {
+            return;
+          }
+          std::string header{
+              boost::asio::buffers_begin(request_.data()),
+              boost::asio::buffers_begin(request_.data()) + length};
+          MakeResponse(header.substr(0, header.find("\r\n")));
+          DoWriteResponse();
+        });
+  }
+
+  void MakeResponse(const std::string& request_line) {
+    const size_t method_end = request_line.find(' ');
+    const size_t target_end = request_line.find(' ', method_end + 1);
+    if (method_end == std::string::npos or target_end == std::string::npos) {
+      MakeResponse("400 Bad Request", "");
+      return;
+    }
+
+    const std::string method = request_line.substr(0, method_end);
+    std::string target =
+        request_line.substr(method_end + 1, target_end - method_end - 1);
+    target = target.substr(0, target.find('?'));
+
+    if (method != "GET") {
+      MakeResponse("405 Method Not Allowed", "");
+    } else if (target != "/metrics") {
+      MakeResponse("404 Not Found", "");
+    } else {
+      MakeResponse("200 OK", Metrics::Render());
+    }
+  }
+
+  void MakeResponse(const std::string& status, const std::string& body) {
+    response_ = "HTTP/1.1 " + status + "\r\n";
+    response_ += "Content-Type: text/plain; version=0.0.4\r\n";
+    response_ += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    response_ += "Connection: close\r\n\r\n";
+    response_ += body;
+  }
+
+  void DoWriteResponse() {
+    auto self(shared_from_this());
+    boost::asio::async_write(
+        socket_, boost::asio::buffer(response_),
+        [this, self](boost::system::error_code ec, std::size_t /*length*/) {
+          boost::system::error_code ignored;
+          socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both,
+                           ignored);
+          socket_.close(ignored);
+        });
+  }
+};
+
+}  // namespace
+
+MetricsListener::MetricsListener(boost::asio::io_context& io_context,
+                                 const short port)
+    : acceptor_(io_context) {
+  boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::tcp::v4(), port);
+  acceptor_.open(endpoint.protocol());
+  acceptor_.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+  acceptor_.bind(endpoint);
+  acceptor_.listen();
+}
+
+MetricsListener::~MetricsListener() { Stop(); }
+
+void MetricsListener::Start() {
+  Log::Print(Log::Level::INFO,
+             "Metrics listening on port " + std::to_string(GetPort()));
+  DoAccept();
+}
+
+unsigned short MetricsListener::GetPort() const {
+  return acceptor_.local_endpoint().port();
+}
+
+void MetricsListener::Stop() {
+  boost::system::error_code ignored;
+  acceptor_.close(ignored);
+}
+
+void MetricsListener::DoAccept() {
+  acceptor_.async_accept([this](boost::system::error_code ec,
+                                boost::asio::ip::tcp::socket socket) {
+    if (ec == boost::asio::error::operation_aborted) {
+      return;
+    }
+    if (not ec) {
+      std::make_shared<MetricsHttpSession>(std::move(socket))->Start();
+    }
+
+    DoAccept();
+  });
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <boost/asio.hpp>
+
+//:
+//: minimal HTTP/1.1 listener serving GET /metrics
+//: runs on the NetworkManager io_context
+//:
+class MetricsListener {
+ public:
+  MetricsListener(boost::asio::io_context& io_context, const short port);
+  ~MetricsListener();
+
+  void Start();
+  void Stop();
+
+  unsigned short GetPort() const;
+
+ private:
+  boost::asio::ip::tcp::acceptor acceptor_;
+
+  void DoAccept();
+};
@@ -4,15 +4,25 @@
 
 #include "logger.h"
 #include "network_utility.h"
+#include "trace_recorder.h"
 
 std::once_flag NetworkManager::once_flag_;
 std::shared_ptr<NetworkManager> NetworkManager::instance_ = nullptr;
+short NetworkManager::listen_port_ = LISTEN_PORT;
+short NetworkManager::metrics_port_ = METRICS_PORT;
 
-NetworkManager::NetworkManager(const short port)
+void NetworkManager::SetPorts(const short listen_port,
+                              const short metrics_port) {
+  listen_port_ = listen_port;
+  metrics_port_ = metrics_port;
+}
+
+NetworkManager::NetworkManager(const short port, const short metrics_port)
     : is_initialize_(false),
       acceptor_(boost::asio::ip::tcp::acceptor(
           io_context_,
-          boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port))) {
+          boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port))),
+      metrics_listener_(new MetricsListener(io_context_, metrics_port)) {
   acceptor_.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
 }
 
@@ -26,12 +36,18 @@ void NetworkManager::Start(const size_t thread_count) {
     return;
   }
 
+  // io_context::run() returns at once when there is no pending work,
+  // so the accept operations are queued before the io threads start
+  DoAccept();
+  metrics_listener_->Start();
+
   for (size_t i = 0; i < thread_count; ++i) {
-    io_threads_.create_thread(
-        boost::bind(&boost::asio::io_service::run, &io_context_));
+    io_threads_.create_thread([this]() {
+      TraceRecorder::SetThreadName("NetworkManager");
+      io_context_.run();
+    });
   }
 
-  DoAccept();
   is_initialize_ = true;
 }
 
@@ -42,6 +58,14 @@ void NetworkManager::Stop() {
   is_initialize_ = false;
 }
 
+unsigned short NetworkManager::GetListenPort() const {
+  return acceptor_.local_endpoint().port();
+}
+
+unsigned short NetworkManager::GetMetricsPort() const {
+  return metrics_listener_->GetPort();
+}
+
 void NetworkManager::DoAccept() {
   acceptor_.async_accept([this](boost::system::error_code ec,
                                 boost::asio::ip::tcp::socket socket) {
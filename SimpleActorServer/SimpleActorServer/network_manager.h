@@ -2,7 +2,9 @@
 
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
+#include <memory>
 
+#include "metrics_listener.h"
 #include "utility.h"
 
 //:
@@ -12,28 +14,38 @@ class NetworkManager {
 #pragma region singleton pattern
  public:
   static std::shared_ptr<NetworkManager>& GetInstance() {
-    std::call_once(NetworkManager::once_flag_,
-                   []() { instance_.reset(new NetworkManager(LISTEN_PORT)); });
+    std::call_once(NetworkManager::once_flag_, []() {
+      instance_.reset(new NetworkManager(listen_port_, metrics_port_));
+    });
     return instance_;
   }
 
   ~NetworkManager();
 
+  //: takes effect only before the first GetInstance(), 0 = ephemeral port
+  static void SetPorts(const short listen_port, const short metrics_port);
+
  private:
-  NetworkManager(const short port);
+  NetworkManager(const short port, const short metrics_port);
 
   static std::once_flag once_flag_;
   static std::shared_ptr<NetworkManager> instance_;
+  static short listen_port_;
+  static short metrics_port_;
 #pragma endregion
 
  public:
   void Start(const size_t thread_count);
   void Stop();
 
+  unsigned short GetListenPort() const;
+  unsigned short GetMetricsPort() const;
+
  private:
   bool is_initialize_;
   boost::asio::io_context io_context_;
   boost::asio::ip::tcp::acceptor acceptor_;
+  std::unique_ptr<MetricsListener> metrics_listener_;
   boost::thread_group io_threads_;
 
   void DoAccept();
@@ -1,47 +1,72 @@
 #include "network_utility.h"
 
-#include <boost/atomic.hpp>
+#include <boost/smart_ptr/detail/spinlock.hpp>
 #include <boost/thread/lock_guard.hpp>
+#include <atomic>
+#include <cstdlib>
 #include <mutex>
 #include <unordered_map>
 
-#include "json.h"
 #include "logger.h"
+#include "metrics.h"
 #include "session.h"
+#include "trace_context.h"
 #include "user_manager.h"
 
 namespace {
 
-boost::detail::spinlock internal_message_lock;
-std::unordered_map<int, internal_callback_t> internal_message_handlers;
+const int INTERNAL_TABLE_SIZE = static_cast<int>(MessageType::EndOfInternal);
+const int MESSAGE_TABLE_SIZE = static_cast<int>(MessageType::EndOfMessage);
 
-boost::detail::spinlock message_lock;
-std::unordered_map<int, msg_callback_t> message_handlers;
+// only written before Freeze(), which happens before the network starts
+std::atomic<bool> handlers_frozen{false};
+internal_callback_t internal_message_handlers[INTERNAL_TABLE_SIZE] = {};
+msg_callback_t message_handlers[MESSAGE_TABLE_SIZE] = {};
 
-std::atomic<int> session_count = 0;
+std::atomic<int> session_count{0};
 boost::detail::spinlock session_lock;
 std::unordered_map<std::string, std::shared_ptr<Session>> sessions;
 
+template <typename Callback>
+void Register(Callback* table, const int table_size, const int msg_type,
+              const Callback cb) {
+  std::string error;
+  if (handlers_frozen.load()) {
+    error = "registered after Freeze()";
+  } else if (msg_type <= 0 or msg_type >= table_size) {
+    error = "out of range";
+  } else if (table[msg_type] != nullptr) {
+    error = "already registered";
+  } else if (cb == nullptr) {
+    error = "null handler";
+  }
+  if (not error.empty()) {
+    Log::Print(Log::Level::FATAL, "MessageHandler: msg_type=" +
+                                      std::to_string(msg_type) + " " + error);
+    std::abort();
+  }
+  table[msg_type] = cb;
+}
+
 }  // namespace
 
-void MessageHandler::RegisterSessionOpened(const internal_callback_t& cb) {
-  boost::lock_guard<boost::detail::spinlock> lock{internal_message_lock};
-  internal_message_handlers.emplace(static_cast<int>(MessageType::SessionOpen),
-                                    cb);
+void MessageHandler::RegisterSessionOpened(const internal_callback_t cb) {
+  Register(internal_message_handlers, INTERNAL_TABLE_SIZE,
+           static_cast<int>(MessageType::SessionOpen), cb);
 }
 
-void MessageHandler::RegisterSessionClosed(const internal_callback_t& cb) {
-  boost::lock_guard<boost::detail::spinlock> lock{internal_message_lock};
-  internal_message_handlers.emplace(static_cast<int>(MessageType::SessionClose),
-                                    cb);
+void MessageHandler::RegisterSessionClosed(const internal_callback_t cb) {
+  Register(internal_message_handlers, INTERNAL_TABLE_SIZE,
+           static_cast<int>(MessageType::SessionClose), cb);
 }
 
 void MessageHandler::RegisterHandler(const int msg_type,
-                                     const msg_callback_t& cb) {
-  boost::lock_guard<boost::detail::spinlock> lock{message_lock};
-  message_handlers.emplace(msg_type, cb);
+                                     const msg_callback_t cb) {
+  Register(message_handlers, MESSAGE_TABLE_SIZE, msg_type, cb);
 }
 
+void MessageHandler::Freeze() { handlers_frozen.store(true); }
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 
@@ -80,27 +105,30 @@ std::shared_ptr<Session> Connection::GetSession(const std::string& session_id) {
   return it->second;
 }
 
-void Connection::DeliverMessage(const std::shared_ptr<Session>& session) {
-  Json msg{session->GetMessage()};
-  if (not msg.IsObject()) {
-    Log::Print(Log::Level::ERROR_,
-               "Connection::DeliverMessage(): failed message parse=" +
-                   session->GetMessage());
-    return;
-  }
+void Connection::DeliverMessage(const std::shared_ptr<Session>& session,
+                                const std::shared_ptr<TraceContext>& trace) {
+  const SimpleMessage& frame = session->GetReadMessage();
 
-  int msg_type;
-  if (not msg.GetAttribute("msg_type", &msg_type)) {
+  // unhandled types stop the parse as soon as msg_type is read
+  msg_callback_t cb;
+  MessageEnvelope envelope;
+  const auto result = Envelope::Parse(
+      frame.body(), frame.body_length(),
+      [&cb](const int msg_type) {
+        return InternalFunction::GetMessageHandler(msg_type, &cb);
+      },
+      &envelope);
+  if (result == Envelope::Result::REJECTED) {
+    Metrics::AddRejectedMessage();
     Log::Print(Log::Level::ERROR_,
-               "Connection::DeliverMessage(): invalid message type=" +
+               "Connection::DeliverMessage(): invalid message handler=" +
                    session->GetMessage());
     return;
   }
-
-  msg_callback_t cb;
-  if (not InternalFunction::GetMessageHandler(msg_type, &cb)) {
+  if (result != Envelope::Result::OK) {
+    Metrics::AddRejectedMessage();
     Log::Print(Log::Level::ERROR_,
-               "Connection::DeliverMessage(): invalid message handler=" +
+               "Connection::DeliverMessage(): failed message parse=" +
                    session->GetMessage());
     return;
   }
@@ -113,20 +141,26 @@ void Connection::DeliverMessage(const std::shared_ptr<Session>& session) {
     return;
   }
 
-  Json body;
-  if (not msg.GetAttribute("msg_body", &body)) {
-    Log::Print(Log::Level::ERROR_,
-               "Connection::DeliverMessage(): invalid message body=" +
-                   session->GetMessage());
-    return;
+  Metrics::AddInboundMessage(envelope.msg_type);
+  if (Log::IsEnabled(Log::Level::DEBUG)) {
+    Log::Print(Log::Level::DEBUG, "Receive Message:" + session->GetMessage());
   }
 
-  Log::Print(Log::Level::DEBUG, "Receive Message:" + msg.ToString());
-
-  user_actor->AsyncTask([cb, session, body = std::move(body.ToString())]() {
-    Json msg{body};
-    cb(session, msg);
-  });
+  Trace::SetMessageType(trace, envelope.msg_type);
+  Trace::Mark(trace, TraceStage::PARSE);
+
+  // the read buffer is reused for the next frame, so the body is copied out
+  // requests stay in one lane to keep their order, ahead of chat fan-out
+  user_actor->AsyncTask(
+      [cb, session, trace, codec = envelope.codec,
+       body = std::string(envelope.body, envelope.body_length)]() {
+        Trace::Mark(trace, TraceStage::USER_MAILBOX);
+        Trace::Scope scope(trace);
+        const MessageBody msg{codec, body.data(), body.size()};
+        cb(session, msg);
+      },
+      MailboxLane::CONTROL);
+  session->PauseReadFor(user_actor);
 }
 
 //-----------------------------------------------------------------------------
@@ -134,31 +168,26 @@ void Connection::DeliverMessage(const std::shared_ptr<Session>& session) {
 
 bool InternalFunction::GetMessageHandler(const int msg_type,
                                          msg_callback_t* handler) {
-  boost::lock_guard<boost::detail::spinlock> lock{message_lock};
-  const auto& it = message_handlers.find(msg_type);
-  if (it == message_handlers.cend()) {
+  if (msg_type <= 0 or msg_type >= MESSAGE_TABLE_SIZE) {
     *handler = nullptr;
     return false;
   }
-  *handler = it->second;
-  return true;
+  *handler = message_handlers[msg_type];
+  return *handler != nullptr;
 }
 
 void InternalFunction::DeliverMessage(const std::shared_ptr<Session>& session,
-                                      const Json& msg) {
-  int msg_type = msg["msg_type"].GetInt();
-
-  internal_callback_t cb;
-  {
-    boost::lock_guard<boost::detail::spinlock> lock{internal_message_lock};
-    const auto& it = internal_message_handlers.find(msg_type);
-    if (it == internal_message_handlers.cend()) {
-      return;
-    }
-    cb = it->second;
+                                      const MessageType msg_type) {
+  const int index = static_cast<int>(msg_type);
+  if (index <= 0 or index >= INTERNAL_TABLE_SIZE) {
+    return;
+  }
+  const internal_callback_t cb = internal_message_handlers[index];
+  if (cb == nullptr) {
+    return;
   }
 
-  switch (static_cast<MessageType>(msg_type)) {
+  switch (msg_type) {
     case MessageType::SessionOpen: {
       cb(session, nullptr);
     } break;
@@ -169,7 +198,8 @@ void InternalFunction::DeliverMessage(const std::shared_ptr<Session>& session,
         return;
       }
       user_actor->AsyncTask(
-          [cb, user_actor, session]() { cb(session, user_actor); });
+          [cb, user_actor, session]() { cb(session, user_actor); },
+          MailboxLane::CONTROL);
     } break;
 
     default:
@@ -3,23 +3,32 @@
 #include <boost/asio.hpp>
 #include <memory>
 
-#include "json.h"
+#include "message_envelope.h"
+#include "simple_message.h"
 
 class ActorBaseModel;
 class Session;
+struct TraceContext;
 
-using internal_callback_t = std::function<void(
-    const std::shared_ptr<Session>&, const std::shared_ptr<ActorBaseModel>)>;
+using internal_callback_t = void (*)(const std::shared_ptr<Session>&,
+                                     const std::shared_ptr<ActorBaseModel>&);
 
-using msg_callback_t =
-    std::function<void(const std::shared_ptr<Session>&, const Json&)>;
+using msg_callback_t = void (*)(const std::shared_ptr<Session>&,
+                                const MessageBody&);
 
+//:
+//: handlers live in flat arrays indexed by MessageType, read without a lock
+//: registering is only allowed until Freeze(). a late, duplicate or out of
+//: range registration logs FATAL and aborts
+//:
 namespace MessageHandler {
 
-void RegisterSessionOpened(const internal_callback_t& cb);
-void RegisterSessionClosed(const internal_callback_t& cb);
+void RegisterSessionOpened(const internal_callback_t cb);
+void RegisterSessionClosed(const internal_callback_t cb);
 
-void RegisterHandler(const int msg_type, const msg_callback_t& cb);
+void RegisterHandler(const int msg_type, const msg_callback_t cb);
+
+void Freeze();
 
 }  // namespace MessageHandler
 
@@ -32,7 +41,8 @@ void EraseSession(const std::string& session_id);
 bool IsSessionOpened(const std::string& session_id);
 std::shared_ptr<Session> GetSession(const std::string& session_id);
 
-void DeliverMessage(const std::shared_ptr<Session>& session);
+void DeliverMessage(const std::shared_ptr<Session>& session,
+                    const std::shared_ptr<TraceContext>& trace);
 
 }  // namespace Connection
 
@@ -40,6 +50,7 @@ namespace InternalFunction {
 
 bool GetMessageHandler(const int msg_type, msg_callback_t* handler);
 
-void DeliverMessage(const std::shared_ptr<Session>& session, const Json& msg);
+void DeliverMessage(const std::shared_ptr<Session>& session,
+                    const MessageType msg_type);
 
 }  // namespace InternalFunction
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "response_frame.h"
+
+#include "messages.h"
+
+namespace {
+
+const MessageType CONSTANT_ACKS[] = {
+    MessageType::RegisterAck,
+    MessageType::EnterRoomAck,
+    MessageType::ExitRoomAck,
+    MessageType::SendChatAck,
+};
+// in enum order, Get() indexes by value
+const ResultType RESULTS[] = {ResultType::Error, ResultType::Sucess};
+const Codec CODECS[] = {Codec::JSON, Codec::BINARY};
+
+const int ACK_COUNT = sizeof(CONSTANT_ACKS) / sizeof(CONSTANT_ACKS[0]);
+const int RESULT_COUNT = sizeof(RESULTS) / sizeof(RESULTS[0]);
+const int CODEC_COUNT = sizeof(CODECS) / sizeof(CODECS[0]);
+
+// written once by Initialize() before the network starts, read only after
+std::shared_ptr<const SimpleMessage> frames[ACK_COUNT][RESULT_COUNT]
+                                           [CODEC_COUNT];
+
+int GetAckIndex(const MessageType msg_type) {
+  for (int i = 0; i < ACK_COUNT; ++i) {
+    if (CONSTANT_ACKS[i] == msg_type) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
+void ResponseFrame::Initialize() {
+  // every constant ack body is {result}, RegisterAck encodes all of them
+  Protocol::RegisterAck ack;
+  for (int i = 0; i < ACK_COUNT; ++i) {
+    for (int result = 0; result < RESULT_COUNT; ++result) {
+      ack.result = static_cast<int>(RESULTS[result]);
+      for (int codec = 0; codec < CODEC_COUNT; ++codec) {
+        frames[i][result][codec] = std::make_shared<const SimpleMessage>(
+            SimpleMessage::MakeMessage(static_cast<int>(CONSTANT_ACKS[i]), ack,
+                                       CODECS[codec]));
+      }
+    }
+  }
+}
+
+std::shared_ptr<const SimpleMessage> ResponseFrame::Get(
+    const MessageType msg_type, const ResultType result_type,
+    const Codec codec) {
+  const int index = GetAckIndex(msg_type);
+  const int result = static_cast<int>(result_type);
+  const int codec_index = static_cast<int>(codec);
+  if (index < 0 or result >= RESULT_COUNT or codec_index >= CODEC_COUNT) {
+    return nullptr;
+  }
+  return frames[index][result][codec_index];
+}
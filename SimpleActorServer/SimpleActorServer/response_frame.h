@@ -0,0 +1,21 @@
+#pragma once
+
+#include <memory>
+
+#include "simple_message.h"
+
+//:
+//: responses whose bytes never change, encoded once at startup in every
+//: codec. a session queues the shared frame, so sending one is a pointer
+//: copy instead of an encode
+//:
+namespace ResponseFrame {
+
+void Initialize();
+
+//: nullptr for a msg_type without a constant {result} body
+std::shared_ptr<const SimpleMessage> Get(const MessageType msg_type,
+                                         const ResultType result_type,
+                                         const Codec codec);
+
+}  // namespace ResponseFrame
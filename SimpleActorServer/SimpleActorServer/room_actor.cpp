@@ -1,14 +1,36 @@
 #include "room_actor.h"
 
+#include <algorithm>
+
+#include <boost/thread/lock_guard.hpp>
+
+#include "chat_batch.h"
 #include "logger.h"
-#include "user_manager.h"
+#include "room_shard_actor.h"
+#include "session.h"
+#include "trace_context.h"
 
-RoomActor::RoomActor() : room_id_(Utility::GenerateStringUuid()) {
+RoomActor::RoomActor()
+    : room_id_(Utility::GenerateStringUuid()),
+      member_count_(0),
+      chat_batch_msec_(ROOM_CHAT_BATCH_MSEC) {
   Log::Print(Log::Level::DEBUG, "CreateRoom...");
 }
 
 RoomActor::~RoomActor() { Log::Print(Log::Level::DEBUG, "DestoryRoom..."); }
 
+std::vector<std::shared_ptr<RoomShardActor>> RoomActor::GetShards() const {
+  boost::lock_guard<boost::detail::spinlock> lock{shard_lock_};
+  return shards_;
+}
+
+void RoomActor::PauseRead(const std::shared_ptr<Session>& session) {
+  session->PauseReadFor(shared_from_this());
+  for (const auto& shard : GetShards()) {
+    session->PauseReadFor(shard);
+  }
+}
+
 void RoomActor::SelfEvent(const int64_t expected_msec) {
   ActorBaseModel::SelfEvent(expected_msec);
   // TODO
@@ -23,23 +45,46 @@ void RoomActor::SendAsyncEvent(const int type,
   }
 
   auto self(shared_from_this());
+  auto trace = Trace::Fork(Trace::Current());
   switch (static_cast<LocalEventType>(type)) {
     case LocalEventType::ENTER_ROOM:
-      this->AsyncTask([this, self, data = std::move(local_data)]() {
-        _EnterRoom(data->user);
-      });
+      this->AsyncTask(
+          [this, self, data = std::move(local_data), trace]() {
+            Trace::Mark(trace, TraceStage::ROOM_MAILBOX);
+            Trace::Scope scope(trace);
+            _EnterRoom(data->session_id, data->nickname, data->session);
+          },
+          MailboxLane::CONTROL);
       break;
 
     case LocalEventType::EXIT_ROOM:
-      this->AsyncTask([this, self, data = std::move(local_data)]() {
-        _ExitRoom(data->session_id);
-      });
+      this->AsyncTask(
+          [this, self, data = std::move(local_data), trace]() {
+            Trace::Mark(trace, TraceStage::ROOM_MAILBOX);
+            Trace::Scope scope(trace);
+            _ExitRoom(data->session_id);
+          },
+          MailboxLane::CONTROL);
       break;
 
     case LocalEventType::BROADCASTING:
-      this->AsyncTask([this, self, data = std::move(local_data)]() {
-        _Broadcasting(data->sender, data->chat_message);
-      });
+      this->AsyncTask(
+          [this, self, data = std::move(local_data), trace]() {
+            Trace::Mark(trace, TraceStage::ROOM_MAILBOX);
+            Trace::Scope scope(trace);
+            _Broadcasting(data->sender, data->chat_message);
+          },
+          MailboxLane::BULK);
+      break;
+
+    case LocalEventType::RENAME_MEMBER:
+      this->AsyncTask(
+          [this, self, data = std::move(local_data), trace]() {
+            Trace::Mark(trace, TraceStage::ROOM_MAILBOX);
+            Trace::Scope scope(trace);
+            _RenameMember(data->session_id, data->nickname);
+          },
+          MailboxLane::CONTROL);
       break;
 
     default:
@@ -50,26 +95,139 @@ void RoomActor::SendAsyncEvent(const int type,
   }
 }
 
-void RoomActor::_EnterRoom(const std::shared_ptr<UserActor>& user) {
+void RoomActor::_EnterRoom(const std::string& session_id,
+                           const std::string& nickname,
+                           const std::shared_ptr<Session>& session) {
   Log::Print(Log::Level::DEBUG, "User EnterRoom");
-  members_.emplace(user->GetSessionId(), user);
+  if (not members_.Add(session_id, nickname, session)) {
+    return;
+  }
+  member_count_.store(members_.GetSize(), std::memory_order_relaxed);
+
+  if (not shards_.empty()) {
+    auto data = std::make_shared<RoomShardActor::LocalEventData>();
+    data->InitEnterShard(session_id, nickname, session);
+    _SendShardEvent(
+        session_id,
+        static_cast<int>(RoomShardActor::LocalEventType::ENTER_SHARD), data);
+  } else if (members_.GetSize() >= ROOM_SHARD_THRESHOLD) {
+    _OpenShards();
+  }
 }
 
 void RoomActor::_ExitRoom(const std::string& session_id) {
   Log::Print(Log::Level::DEBUG, "User ExitRoom");
-  members_.erase(session_id);
+  if (not members_.Remove(session_id)) {
+    return;
+  }
+  member_count_.store(members_.GetSize(), std::memory_order_relaxed);
+
+  if (not shards_.empty()) {
+    auto data = std::make_shared<RoomShardActor::LocalEventData>();
+    data->InitExitShard(session_id);
+    _SendShardEvent(
+        session_id,
+        static_cast<int>(RoomShardActor::LocalEventType::EXIT_SHARD), data);
+  }
+}
+
+void RoomActor::_RenameMember(const std::string& session_id,
+                              const std::string& nickname) {
+  if (not members_.Rename(session_id, nickname)) {
+    return;
+  }
+
+  if (not shards_.empty()) {
+    auto data = std::make_shared<RoomShardActor::LocalEventData>();
+    data->InitRenameShard(session_id, nickname);
+    _SendShardEvent(
+        session_id,
+        static_cast<int>(RoomShardActor::LocalEventType::RENAME_SHARD), data);
+  }
 }
 
 void RoomActor::_Broadcasting(const std::string& sender,
                               const std::string& chat_message) {
-  for (const auto& entry : members_) {
-    auto user_actor = entry.second.lock();
-    if (not user_actor) {
-      continue;
+  const int64_t batch_msec = chat_batch_msec_.load(std::memory_order_relaxed);
+  if (batch_msec > 0 or pending_chats_) {
+    // the first chat of a window opens it, the rest join the batch
+    if (not pending_chats_) {
+      pending_chats_.reset(new Protocol::BroadcastingChatBatch());
+      pending_chats_->result = static_cast<int>(ResultType::Sucess);
+      auto self(shared_from_this());
+      this->AsyncTask([this, self]() { _FlushChatBatch(); },
+                      std::max<int64_t>(batch_msec, 1));
     }
-    auto data = std::make_shared<UserActor::LocalEventData>();
-    data->InitChatMessage(sender, chat_message);
-    user_actor->SendAsyncEvent(
-        static_cast<int>(UserActor::LocalEventType::SEND_CHAT_MESSAGE), data);
+    pending_chats_->senders.emplace_back(sender);
+    pending_chats_->chat_messages.emplace_back(chat_message);
+    return;
+  }
+
+  if (not shards_.empty()) {
+    auto data = std::make_shared<RoomShardActor::LocalEventData>();
+    data->InitBroadcasting(sender, chat_message);
+    _SendAllShardsEvent(
+        static_cast<int>(RoomShardActor::LocalEventType::BROADCASTING), data);
+    return;
+  }
+
+  members_.SendChat(sender, chat_message);
+}
+
+void RoomActor::_FlushChatBatch() {
+  if (not pending_chats_) {
+    return;
+  }
+  auto chat_batch = std::make_shared<const ChatBatch>(*pending_chats_);
+  pending_chats_.reset();
+
+  if (not shards_.empty()) {
+    auto data = std::make_shared<RoomShardActor::LocalEventData>();
+    data->InitBroadcastingBatch(chat_batch);
+    _SendAllShardsEvent(
+        static_cast<int>(RoomShardActor::LocalEventType::BROADCASTING_BATCH),
+        data);
+    return;
+  }
+
+  members_.SendChatBatch(*chat_batch);
+}
+
+void RoomActor::_OpenShards() {
+  Log::Print(Log::Level::INFO, "RoomActor::_OpenShards(): " + room_id_ + " " +
+                                   std::to_string(members_.GetSize()));
+  std::vector<std::shared_ptr<RoomShardActor>> shards;
+  shards.reserve(ROOM_SHARD_COUNT);
+  for (size_t i = 0; i < ROOM_SHARD_COUNT; ++i) {
+    shards.emplace_back(std::make_shared<RoomShardActor>(room_id_, i));
+  }
+  {
+    boost::lock_guard<boost::detail::spinlock> lock{shard_lock_};
+    shards_.swap(shards);
+  }
+
+  const auto& session_ids = members_.GetSessionIds();
+  const auto& nicknames = members_.GetNicknames();
+  const auto& sessions = members_.GetSessions();
+  for (size_t i = 0; i < sessions.size(); ++i) {
+    auto data = std::make_shared<RoomShardActor::LocalEventData>();
+    data->InitEnterShard(session_ids[i], nicknames[i], sessions[i]);
+    _SendShardEvent(
+        session_ids[i],
+        static_cast<int>(RoomShardActor::LocalEventType::ENTER_SHARD), data);
+  }
+}
+
+void RoomActor::_SendShardEvent(const std::string& session_id, const int type,
+                                const std::shared_ptr<IEventData>& data) {
+  const size_t index = std::hash<std::string>()(session_id) % shards_.size();
+  shards_[index]->SendAsyncEvent(type, data);
+}
+
+void RoomActor::_SendAllShardsEvent(const int type,
+                                    const std::shared_ptr<IEventData>& data) {
+  // each shard keeps the room's order, so a sender's chats stay in order
+  for (const auto& shard : shards_) {
+    shard->SendAsyncEvent(type, data);
   }
 }
\ No newline at end of file
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
-#include <unordered_map>
+#include <vector>
+
+#include <boost/smart_ptr/detail/spinlock.hpp>
 
 #include "actor_base_model.h"
+#include "member_table.h"
+#include "messages.h"
 
-class UserActor;
+class RoomShardActor;
+class Session;
 
 class RoomActor : public ActorBaseModel {
  public:
@@ -14,10 +20,15 @@ class RoomActor : public ActorBaseModel {
     ENTER_ROOM,
     EXIT_ROOM,
     BROADCASTING,
+    RENAME_MEMBER,
   };
   struct LocalEventData : IEventData {
-    void InitEnterRoom(const std::shared_ptr<UserActor> &_user) {
-      user = _user;
+    void InitEnterRoom(const std::string &session_id_,
+                       const std::string &_nickname,
+                       const std::shared_ptr<Session> &_session) {
+      session_id = session_id_;
+      nickname = _nickname;
+      session = _session;
     }
     void InitExitRoom(const std::string &session_id_) {
       session_id = session_id_;
@@ -27,8 +38,14 @@ class RoomActor : public ActorBaseModel {
       sender = _sender;
       chat_message = _chat_message;
     }
-    std::shared_ptr<UserActor> user;
+    void InitRenameMember(const std::string &session_id_,
+                          const std::string &_nickname) {
+      session_id = session_id_;
+      nickname = _nickname;
+    }
     std::string session_id;
+    std::string nickname;
+    std::shared_ptr<Session> session;
     std::string sender;
     std::string chat_message;
   };
@@ -37,6 +54,23 @@ class RoomActor : public ActorBaseModel {
   virtual ~RoomActor();
 
   inline std::string GetRoomId() const { return room_id_; }
+  inline size_t GetMemberCount() const {
+    return member_count_.load(std::memory_order_relaxed);
+  }
+  //: chats within msec are sent to members as one BroadcastingChatBatch,
+  //: 0 sends each chat on its own
+  inline void SetChatBatchWindow(const int64_t msec) {
+    chat_batch_msec_.store(msec, std::memory_order_relaxed);
+  }
+
+  //: safe from any thread, empty until the room opens its shards
+  std::vector<std::shared_ptr<RoomShardActor>> GetShards() const;
+  //: Session::PauseReadFor() the room and each of its shards, a sharded
+  //: room only forwards chats, the shard mailboxes are the ones that fill
+  void PauseRead(const std::shared_ptr<Session> &session);
+
+  virtual const char *GetActorType() const { return "RoomActor"; }
+  virtual std::string GetActorId() const { return room_id_; }
 
   virtual void SelfEvent(const int64_t expected_msec);
   virtual void SendAsyncEvent(const int type,
@@ -44,10 +78,26 @@ class RoomActor : public ActorBaseModel {
 
  private:
   const std::string room_id_;
-  std::unordered_map<std::string, std::weak_ptr<UserActor>> members_;
+  MemberTable members_;
+  std::atomic<size_t> member_count_;
+  std::atomic<int64_t> chat_batch_msec_;
+  std::unique_ptr<Protocol::BroadcastingChatBatch> pending_chats_;
+  //: opened once members_ reaches ROOM_SHARD_THRESHOLD and kept after
+  //: the room only takes shard_lock_ to open them, GetShards() to read them
+  std::vector<std::shared_ptr<RoomShardActor>> shards_;
+  mutable boost::detail::spinlock shard_lock_ = BOOST_DETAIL_SPINLOCK_INIT;
 
-  void _EnterRoom(const std::shared_ptr<UserActor> &user);
+  void _EnterRoom(const std::string &session_id, const std::string &nickname,
+                  const std::shared_ptr<Session> &session);
   void _ExitRoom(const std::string &session_id);
+  void _RenameMember(const std::string &session_id,
+                     const std::string &nickname);
   void _Broadcasting(const std::string &sender,
                      const std::string &chat_message);
+  void _FlushChatBatch();
+  void _OpenShards();
+  void _SendShardEvent(const std::string &session_id, const int type,
+                       const std::shared_ptr<IEventData> &data);
+  void _SendAllShardsEvent(const int type,
+                           const std::shared_ptr<IEventData> &data);
 };
\ No newline at end of file
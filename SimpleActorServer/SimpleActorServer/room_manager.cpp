@@ -4,12 +4,39 @@
 #include <boost/date_time.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/thread/lock_guard.hpp>
+#include <limits>
 #include <unordered_map>
 
+#include "logger.h"
+
 namespace {
 
+const size_t NOT_OPEN = std::numeric_limits<size_t>::max();
+
+struct RoomEntry {
+  std::shared_ptr<RoomActor> room;
+  size_t seats;       // taken by MatchRoom, given back by LeaveRoom
+  size_t open_index;  // in open_rooms, NOT_OPEN while the room is full
+};
+
 boost::detail::spinlock room_lock;
-std::unordered_map<std::string, std::shared_ptr<RoomActor>> rooms;
+std::unordered_map<std::string, RoomEntry> rooms;
+// rooms with a free seat, dense so a match is one random index
+// the map's nodes don't move, so the pointers stay valid
+std::vector<RoomEntry*> open_rooms;
+
+void OpenSeats(RoomEntry* entry) {
+  entry->open_index = open_rooms.size();
+  open_rooms.emplace_back(entry);
+}
+
+void CloseSeats(RoomEntry* entry) {
+  RoomEntry* last = open_rooms.back();
+  open_rooms[entry->open_index] = last;
+  last->open_index = entry->open_index;
+  open_rooms.pop_back();
+  entry->open_index = NOT_OPEN;
+}
 
 }  // namespace
 
@@ -19,21 +46,47 @@ std::shared_ptr<RoomActor> RoomManager::CreateRoom() {
 
   {
     boost::lock_guard<boost::detail::spinlock> lock{room_lock};
-    rooms.emplace(room_actor->GetRoomId(), room_actor);
+    auto it = rooms.emplace(room_actor->GetRoomId(),
+                            RoomEntry{room_actor, 0, NOT_OPEN})
+                  .first;
+    OpenSeats(&it->second);
   }
 
   return room_actor;
 }
 
-std::shared_ptr<RoomActor> RoomManager::GetRandomRoom() {
+std::shared_ptr<RoomActor> RoomManager::MatchRoom() {
+  while (true) {
+    {
+      boost::lock_guard<boost::detail::spinlock> lock{room_lock};
+      if (not open_rooms.empty()) {
+        RoomEntry* entry = open_rooms[Utility::RandomGenerateNumber(
+            0, static_cast<int>(open_rooms.size()))];
+        if (++entry->seats >= ROOM_CAPACITY) {
+          CloseSeats(entry);
+        }
+        return entry->room;
+      }
+    }
+
+    // racing matches may each open one, the spare rooms fill up later
+    auto room_actor = CreateRoom();
+    Log::Print(Log::Level::INFO, "RoomManager::MatchRoom(): every room is "
+                                 "full, opened " + room_actor->GetRoomId());
+  }
+}
+
+void RoomManager::LeaveRoom(const std::string& room_id) {
   boost::lock_guard<boost::detail::spinlock> lock{room_lock};
-  if (rooms.empty()) {
-    return nullptr;
+  auto it = rooms.find(room_id);
+  if (it == rooms.end() or it->second.seats == 0) {
+    return;
+  }
+  RoomEntry* entry = &it->second;
+  --entry->seats;
+  if (entry->open_index == NOT_OPEN and entry->seats < ROOM_CAPACITY) {
+    OpenSeats(entry);
   }
-  auto random_it = std::next(
-      std::begin(rooms),
-      Utility::RandomGenerateNumber(0, static_cast<int>(rooms.size())));
-  return random_it->second;
 }
 
 std::shared_ptr<RoomActor> RoomManager::GetRoom(const std::string& room_id) {
@@ -41,12 +94,42 @@ std::shared_ptr<RoomActor> RoomManager::GetRoom(const std::string& room_id) {
   {
     boost::lock_guard<boost::detail::spinlock> lock{room_lock};
     const auto& it = rooms.find(room_id);
-    if (it != rooms.cend()) room_acotr = it->second;
+    if (it != rooms.cend()) room_acotr = it->second.room;
   }
   return room_acotr;
 }
 
 void RoomManager::EraseRoom(const std::string& room_id) {
   boost::lock_guard<boost::detail::spinlock> lock{room_lock};
-  rooms.erase(room_id);
+  auto it = rooms.find(room_id);
+  if (it == rooms.end()) {
+    return;
+  }
+  if (it->second.open_index != NOT_OPEN) {
+    CloseSeats(&it->second);
+  }
+  rooms.erase(it);
+}
+
+size_t RoomManager::GetRoomCount() {
+  boost::lock_guard<boost::detail::spinlock> lock{room_lock};
+  return rooms.size();
+}
+
+std::vector<size_t> RoomManager::GetRoomMemberCounts() {
+  std::vector<size_t> member_counts;
+  boost::lock_guard<boost::detail::spinlock> lock{room_lock};
+  member_counts.reserve(rooms.size());
+  for (const auto& entry : rooms) {
+    member_counts.emplace_back(entry.second.room->GetMemberCount());
+  }
+  return member_counts;
+}
+
+void RoomManager::ForEachRoom(
+    const std::function<void(const std::shared_ptr<RoomActor>&)>& visit) {
+  boost::lock_guard<boost::detail::spinlock> lock{room_lock};
+  for (const auto& entry : rooms) {
+    visit(entry.second.room);
+  }
 }
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "room_actor.h"
 
@@ -11,8 +13,15 @@
 namespace RoomManager {
 
 std::shared_ptr<RoomActor> CreateRoom();
-std::shared_ptr<RoomActor> GetRandomRoom();
+//: a random room with a free seat, taken until LeaveRoom
+//: opens a new room when every room has ROOM_CAPACITY seats taken
+std::shared_ptr<RoomActor> MatchRoom();
+void LeaveRoom(const std::string& room_id);
 std::shared_ptr<RoomActor> GetRoom(const std::string& room_id);
 void EraseRoom(const std::string& room_id);
+size_t GetRoomCount();
+std::vector<size_t> GetRoomMemberCounts();
+void ForEachRoom(
+    const std::function<void(const std::shared_ptr<RoomActor>&)>& visit);
 
 }  // namespace RoomManager
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "room_shard_actor.h"
+
+#include <functional>
+
+#include "logger.h"
+#include "trace_context.h"
+
+RoomShardActor::RoomShardActor(const std::string& room_id,
+                               const size_t shard_index)
+    : ActorBaseModel(std::hash<std::string>()(room_id) + shard_index),
+      shard_id_(room_id + "/" + std::to_string(shard_index)) {}
+
+RoomShardActor::~RoomShardActor() {}
+
+void RoomShardActor::SendAsyncEvent(const int type,
+                                    const std::shared_ptr<IEventData>& data) {
+  auto local_data = std::dynamic_pointer_cast<LocalEventData>(data);
+  if (not local_data) {
+    Log::Print(Log::Level::ERROR_,
+               "RoomShardActor::SendAsyncEvent(): invalid data");
+    return;
+  }
+
+  // membership uses the bulk lane too, a member that left after a chat
+  // still gets it like in an unsharded room
+  auto self(shared_from_this());
+  auto trace = Trace::Fork(Trace::Current());
+  switch (static_cast<LocalEventType>(type)) {
+    case LocalEventType::ENTER_SHARD:
+      this->AsyncTask([this, self, data = std::move(local_data)]() {
+        _EnterShard(data->session_id, data->nickname, data->session);
+      });
+      break;
+
+    case LocalEventType::EXIT_SHARD:
+      this->AsyncTask([this, self, data = std::move(local_data)]() {
+        _ExitShard(data->session_id);
+      });
+      break;
+
+    case LocalEventType::RENAME_SHARD:
+      this->AsyncTask([this, self, data = std::move(local_data)]() {
+        _RenameShard(data->session_id, data->nickname);
+      });
+      break;
+
+    case LocalEventType::BROADCASTING:
+      this->AsyncTask([this, self, data = std::move(local_data), trace]() {
+        Trace::Mark(trace, TraceStage::FAN_OUT);
+        Trace::Scope scope(trace);
+        _Broadcasting(data->sender, data->chat_message);
+      });
+      break;
+
+    case LocalEventType::BROADCASTING_BATCH:
+      this->AsyncTask([this, self, data = std::move(local_data), trace]() {
+        Trace::Mark(trace, TraceStage::FAN_OUT);
+        Trace::Scope scope(trace);
+        _BroadcastingBatch(data->chat_batch);
+      });
+      break;
+
+    default:
+      Log::Print(Log::Level::ERROR_, "RoomShardActor::SendAsyncEvent(" +
+                                         std::to_string(type) +
+                                         "): invalid type");
+      break;
+  }
+}
+
+void RoomShardActor::_EnterShard(const std::string& session_id,
+                                 const std::string& nickname,
+                                 const std::shared_ptr<Session>& session) {
+  members_.Add(session_id, nickname, session);
+}
+
+void RoomShardActor::_ExitShard(const std::string& session_id) {
+  members_.Remove(session_id);
+}
+
+void RoomShardActor::_RenameShard(const std::string& session_id,
+                                  const std::string& nickname) {
+  members_.Rename(session_id, nickname);
+}
+
+void RoomShardActor::_Broadcasting(const std::string& sender,
+                                   const std::string& chat_message) {
+  members_.SendChat(sender, chat_message);
+}
+
+void RoomShardActor::_BroadcastingBatch(
+    const std::shared_ptr<const ChatBatch>& chat_batch) {
+  members_.SendChatBatch(*chat_batch);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "actor_base_model.h"
+#include "member_table.h"
+
+class ChatBatch;
+class Session;
+
+//:
+//: owns a slice of a large room's members so its broadcasts fan out on
+//: several workers, the room sends every shard the same events in order
+//:
+class RoomShardActor : public ActorBaseModel {
+ public:
+  enum class LocalEventType {
+    NONE = 0,
+    ENTER_SHARD,
+    EXIT_SHARD,
+    BROADCASTING,
+    BROADCASTING_BATCH,
+    RENAME_SHARD,
+  };
+  struct LocalEventData : IEventData {
+    void InitEnterShard(const std::string& _session_id,
+                        const std::string& _nickname,
+                        const std::shared_ptr<Session>& _session) {
+      session_id = _session_id;
+      nickname = _nickname;
+      session = _session;
+    }
+    void InitExitShard(const std::string& _session_id) {
+      session_id = _session_id;
+    }
+    void InitBroadcasting(const std::string& _sender,
+                          const std::string& _chat_message) {
+      sender = _sender;
+      chat_message = _chat_message;
+    }
+    void InitBroadcastingBatch(
+        const std::shared_ptr<const ChatBatch>& _chat_batch) {
+      chat_batch = _chat_batch;
+    }
+    void InitRenameShard(const std::string& _session_id,
+                         const std::string& _nickname) {
+      session_id = _session_id;
+      nickname = _nickname;
+    }
+    std::string session_id;
+    std::string nickname;
+    std::shared_ptr<Session> session;
+    std::string sender;
+    std::string chat_message;
+    std::shared_ptr<const ChatBatch> chat_batch;
+  };
+
+  //: the shards of a room take consecutive affinity keys from its id, so
+  //: they have distinct home workers while ROOM_SHARD_COUNT doesn't exceed
+  //: THREAD_POOL_THREAD_COUNT
+  RoomShardActor(const std::string& room_id, const size_t shard_index);
+  virtual ~RoomShardActor();
+
+  virtual const char* GetActorType() const { return "RoomShardActor"; }
+  virtual std::string GetActorId() const { return shard_id_; }
+
+  virtual void SendAsyncEvent(const int type,
+                              const std::shared_ptr<IEventData>&);
+
+ private:
+  const std::string shard_id_;  // room id and shard index
+  MemberTable members_;
+
+  void _EnterShard(const std::string& session_id, const std::string& nickname,
+                   const std::shared_ptr<Session>& session);
+  void _ExitShard(const std::string& session_id);
+  void _RenameShard(const std::string& session_id,
+                    const std::string& nickname);
+  void _Broadcasting(const std::string& sender,
+                     const std::string& chat_message);
+  void _BroadcastingBatch(const std::shared_ptr<const ChatBatch>& chat_batch);
+};
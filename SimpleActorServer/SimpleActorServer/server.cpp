@@ -3,15 +3,18 @@
 #include <boost/lexical_cast.hpp>
 #include <memory>
 
+#include "clock.h"
 #include "logger.h"
 #include "network_manager.h"
 #include "network_utility.h"
+#include "response_frame.h"
 #include "room_manager.h"
 #include "session.h"
 #include "simple_message.h"
 #include "thread_pool_manager.h"
 #include "user_manager.h"
 #include "utility.h"
+#include "watchdog.h"
 
 namespace {
 
@@ -39,6 +42,18 @@ void PrintStatus() {
       boost::lexical_cast<std::string>(Connection::GetCunnectionCount()) + '\n';
   profiling += "remain event count : " +
                boost::lexical_cast<std::string>(status.queue_size) + '\n';
+  if (ThreadPoolManager::GetInstance()->IsAffinity()) {
+    const auto activations =
+        ThreadPoolManager::GetInstance()->GetActivationStatus();
+    const uint64_t total = activations.local + activations.migrated;
+    profiling += "local / migrated activation : " +
+                 boost::lexical_cast<std::string>(activations.local) + " / " +
+                 boost::lexical_cast<std::string>(activations.migrated) +
+                 " (" +
+                 boost::lexical_cast<std::string>(
+                     total == 0 ? 0 : activations.local * 100 / total) +
+                 "% local)\n";
+  }
   profiling += "............................................\n";
 
   Log::Print(Log::Level::INFO, profiling);
@@ -67,11 +82,14 @@ Server ::~Server() {
 }
 
 void Server::Start() {
+  Clock::Start();
   Initialize();
   thread_ = std::make_unique<boost::thread>(RunThread);
+  watchdog_ = std::make_unique<Watchdog>();
 }
 
 void Server::Stop() {
+  watchdog_.reset();
   ThreadPoolManager::GetInstance()->Stop();
 
   if (!!thread_ and thread_->joinable()) {
@@ -79,14 +97,17 @@ void Server::Stop() {
     thread_->join();
   }
   thread_.reset();
+  Clock::Stop();
 }
 
 void Server::Initialize() {
   Log::SetLogLevel(Log::Level::INFO);
 
-  NetworkManager::GetInstance()->Start(ASIO_THREAD_COUNT);
-
+  ResponseFrame::Initialize();
   UserActor::InitializeHandler();
+  MessageHandler::Freeze();
+
+  NetworkManager::GetInstance()->Start(ASIO_THREAD_COUNT);
 
   RoomManager::CreateRoom();
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 #include "logger.h"
 
+class Watchdog;
+
 class Server {
  public:
   Server();
@@ -15,6 +17,7 @@ class Server {
 
  private:
   std::unique_ptr<boost::thread> thread_;
+  std::unique_ptr<Watchdog> watchdog_;
 
   void Initialize();
 };
\ No newline at end of file
@@ -1,56 +1,270 @@
 #include "session.h"
 
+#include <boost/thread/lock_guard.hpp>
+#include <atomic>
 #include <memory>
 
-#include "json.h"
+#include "actor_base_model.h"
+#include "clock.h"
 #include "logger.h"
+#include "messages.h"
+#include "metrics.h"
 #include "network_utility.h"
+#include "response_frame.h"
+#include "session_capture.h"
+#include "trace_recorder.h"
 #include "user_manager.h"
 #include "utility.h"
 
+namespace {
+
+std::atomic<OutboundPolicy> outbound_policy{OutboundPolicy::DROP_OLDEST};
+
+}  // namespace
+
 Session::Session(boost::asio::ip::tcp::socket&& socket)
-    : session_id_(Utility::GenerateStringUuid()), socket_(std::move(socket)) {
+    : session_id_(Utility::GenerateStringUuid()),
+      socket_(std::move(socket)),
+      codec_(Codec::JSON),
+      read_begin_usec_(0),
+      write_begin_usec_(0),
+      read_holds_(0),
+      is_read_parked_(false),
+      write_bytes_(0),
+      over_limit_msec_(0),
+      grace_timer_(socket_.get_executor()),
+      is_grace_armed_(false),
+      is_disconnecting_(false) {
   Log::Print(Log::Level::DEBUG, "Create Session");
 }
 
 Session::~Session() { Log::Print(Log::Level::DEBUG, "Close Session"); }
 
 void Session::SendMessage(const SimpleMessage& msg) {
-  bool write_in_progress = not write_msgs_.empty();
-  write_msgs_.push_back(msg);
+  SendMessage(std::make_shared<const SimpleMessage>(msg));
+}
+
+void Session::SendMessage(std::shared_ptr<const SimpleMessage> msg) {
+  Enqueue({std::move(msg), Trace::Fork(Trace::Current()), false, ""});
+}
+
+void Session::SendBroadcast(std::shared_ptr<const SimpleMessage> msg,
+                            const std::string& sender) {
+  Enqueue({std::move(msg), Trace::Fork(Trace::Current()), true, sender});
+}
+
+void Session::SetOutboundPolicy(const OutboundPolicy policy) {
+  outbound_policy.store(policy);
+}
+
+OutboundPolicy Session::GetOutboundPolicy() { return outbound_policy.load(); }
+
+void Session::Enqueue(OutboundMessage&& outbound) {
+  const size_t length = outbound.msg->length();
+  bool write_in_progress = false;
+  bool is_grace_started = false;
+  bool has_room = false;
+  {
+    boost::lock_guard<boost::detail::spinlock> lock{write_lock_};
+    has_room =
+        write_bytes_ + length <= SESSION_OUTBOUND_LIMIT_BYTES or
+        MakeRoom(outbound, &is_grace_started);
+    if (has_room) {
+      write_in_progress = not write_msgs_.empty();
+      write_bytes_ += length;
+      write_msgs_.push_back(std::move(outbound));
+    }
+  }
+  if (is_grace_started) {
+    auto self(shared_from_this());
+    boost::asio::post(socket_.get_executor(), [this, self]() {
+      WaitForGrace(SESSION_OUTBOUND_GRACE_MSEC);
+    });
+  }
+  if (not has_room) {
+    return;
+  }
   if (not write_in_progress) {
-    DoWrite();
+    // the socket is only touched from its io threads
+    auto self(shared_from_this());
+    boost::asio::post(socket_.get_executor(), [this, self]() { DoWrite(); });
   }
 }
 
+bool Session::MakeRoom(const OutboundMessage& outbound,
+                       bool* is_grace_started) {
+  const size_t length = outbound.msg->length();
+  const OutboundPolicy policy = outbound_policy.load();
+  if (over_limit_msec_ == 0) {
+    over_limit_msec_ = Clock::GetMillis();
+  }
+  // the peer gets the grace period to catch up, meanwhile broadcasts are
+  // dropped like under DROP_OLDEST
+  if (policy == OutboundPolicy::DISCONNECT and not is_grace_armed_ and
+      not is_disconnecting_) {
+    is_grace_armed_ = true;
+    *is_grace_started = true;
+  }
+
+  // the front is being written and stays
+  if (policy == OutboundPolicy::COALESCE and outbound.is_broadcast and
+      not outbound.sender.empty()) {
+    for (auto it = write_msgs_.begin() + 1; it != write_msgs_.end(); ++it) {
+      if (it->is_broadcast and it->sender == outbound.sender) {
+        write_bytes_ -= it->msg->length();
+        write_msgs_.erase(it);
+        Metrics::AddOutboundCoalesced();
+        break;
+      }
+    }
+  }
+  auto it = write_msgs_.begin() + 1;
+  while (write_bytes_ + length > SESSION_OUTBOUND_LIMIT_BYTES and
+         it != write_msgs_.end()) {
+    if (it->is_broadcast) {
+      write_bytes_ -= it->msg->length();
+      it = write_msgs_.erase(it);
+      Metrics::AddOutboundDropped();
+    } else {
+      ++it;
+    }
+  }
+
+  // acks go out whatever is queued
+  if (write_bytes_ + length <= SESSION_OUTBOUND_LIMIT_BYTES or
+      not outbound.is_broadcast) {
+    return true;
+  }
+  Metrics::AddOutboundDropped();
+  return false;
+}
+
+void Session::WaitForGrace(const int64_t delay_msec) {
+  grace_timer_.expires_after(std::chrono::milliseconds(delay_msec));
+  auto self(shared_from_this());
+  grace_timer_.async_wait([this, self](boost::system::error_code ec) {
+    int64_t remain_msec = 0;
+    bool is_expired = false;
+    {
+      boost::lock_guard<boost::detail::spinlock> lock{write_lock_};
+      if (not ec and over_limit_msec_ != 0 and
+          Connection::IsSessionOpened(session_id_)) {
+        remain_msec =
+            over_limit_msec_ + SESSION_OUTBOUND_GRACE_MSEC - Clock::GetMillis();
+        is_expired = remain_msec <= 0;
+        is_disconnecting_ = is_expired;
+      }
+      is_grace_armed_ = remain_msec > 0;
+    }
+    if (is_expired) {
+      Metrics::AddOutboundDisconnect();
+      Disconnect();
+    } else if (remain_msec > 0) {
+      // caught up and fell behind again, the grace runs from the new start
+      WaitForGrace(remain_msec);
+    }
+  });
+}
+
+void Session::Disconnect() {
+  auto self(shared_from_this());
+  boost::asio::post(socket_.get_executor(), [this, self]() {
+    Log::Print(Log::Level::WARNING,
+               "Session::Disconnect(): outbound queue over the limit=" +
+                   session_id_);
+    boost::system::error_code ec;
+    socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+    socket_.close(ec);
+  });
+}
+
+void Session::SendResultMessage(const std::shared_ptr<Session>& session,
+                                const MessageType msg_type,
+                                const ResultType result_type) {
+  auto frame = ResponseFrame::Get(msg_type, result_type, session->GetCodec());
+  if (!!frame) {
+    session->SendMessage(std::move(frame));
+    return;
+  }
+
+  // every ack body is {result}, any of them encodes it
+  Protocol::RegisterAck ack;
+  ack.result = static_cast<int>(result_type);
+  session->SendMessage(SimpleMessage::MakeMessage(static_cast<int>(msg_type),
+                                                  ack, session->GetCodec()));
+}
+
 void Session::SendErrorMessage(const std::shared_ptr<Session>& session,
                                const MessageType msg_type,
                                const ResultType result_type) {
-  Json res_doc;
-  res_doc.SetObject();
-  res_doc.SetAttribute("result", static_cast<int>(result_type));
-  auto response =
-      SimpleMessage::MakeMessage(static_cast<int>(msg_type), res_doc);
-  session->SendMessage(response);
+  SendResultMessage(session, msg_type, result_type);
 }
 
 void Session::Start() {
-  Json msg;
-  msg.SetObject();
-  msg.SetAttribute("msg_type", static_cast<int>(MessageType::SessionOpen));
-  InternalFunction::DeliverMessage(shared_from_this(), msg);
+  InternalFunction::DeliverMessage(shared_from_this(),
+                                   MessageType::SessionOpen);
+
+  DoReadHeader();
+}
+
+void Session::PauseReadFor(const std::shared_ptr<ActorBaseModel>& actor) {
+  if (not actor->IsOverloaded()) {
+    return;
+  }
+
+  {
+    boost::lock_guard<boost::detail::spinlock> lock{read_lock_};
+    ++read_holds_;
+  }
+  auto self(shared_from_this());
+  if (actor->WaitForDrain([self]() { self->ResumeRead(); })) {
+    Metrics::AddReadPause();
+    return;
+  }
+  ResumeRead();  // drained in the meantime
+}
+
+bool Session::IsReadPaused() const {
+  boost::lock_guard<boost::detail::spinlock> lock{read_lock_};
+  return read_holds_ > 0;
+}
 
+void Session::ContinueRead() {
+  {
+    boost::lock_guard<boost::detail::spinlock> lock{read_lock_};
+    if (read_holds_ > 0) {
+      is_read_parked_ = true;
+      return;
+    }
+  }
   DoReadHeader();
 }
 
+void Session::ResumeRead() {
+  bool is_parked = false;
+  {
+    boost::lock_guard<boost::detail::spinlock> lock{read_lock_};
+    is_parked = (--read_holds_ == 0 and is_read_parked_);
+    if (is_parked) {
+      is_read_parked_ = false;
+    }
+  }
+  if (is_parked) {
+    auto self(shared_from_this());
+    boost::asio::post(socket_.get_executor(),
+                      [this, self]() { DoReadHeader(); });
+  }
+}
+
 void Session::OnClosed() {
   if (Connection::IsSessionOpened(session_id_)) {
-    Json msg;
-    msg.SetObject();
-    msg.SetAttribute("msg_type", static_cast<int>(MessageType::SessionClose));
-    InternalFunction::DeliverMessage(shared_from_this(), msg);
+    InternalFunction::DeliverMessage(shared_from_this(),
+                                     MessageType::SessionClose);
 
     Connection::EraseSession(session_id_);
+    if (SessionCapture::IsCapturing()) {
+      SessionCapture::AddClose(session_id_);
+    }
   }
 }
 
@@ -69,13 +283,29 @@ void Session::DoReadHeader() {
 }
 
 void Session::DoReadBody() {
+  read_trace_ = Trace::Begin();
+  if (TraceRecorder::IsRecording()) {
+    read_begin_usec_ = Clock::GetMicros();
+  }
   auto self(shared_from_this());
   boost::asio::async_read(
       socket_, boost::asio::buffer(read_msg_.body(), read_msg_.body_length()),
-      [this, self](boost::system::error_code ec, std::size_t /*length*/) {
+      [this, self](boost::system::error_code ec, std::size_t length) {
         if (!ec) {
-          Connection::DeliverMessage(self);
-          DoReadHeader();
+          Metrics::AddInboundFrame(SimpleMessage::header_length + length);
+          if (TraceRecorder::IsRecording() and read_begin_usec_ != 0) {
+            TraceRecorder::AddSocketIo("ReadBody", session_id_, length,
+                                       read_begin_usec_,
+                                       Clock::GetMicros());
+          }
+          read_begin_usec_ = 0;
+          if (SessionCapture::IsCapturing()) {
+            SessionCapture::AddFrame(session_id_, read_msg_.body(), length);
+          }
+          auto trace = std::move(read_trace_);
+          Trace::Mark(trace, TraceStage::SOCKET_READ);
+          Connection::DeliverMessage(self, trace);
+          ContinueRead();
         } else {
           OnClosed();
         }
@@ -83,15 +313,39 @@ void Session::DoReadBody() {
 }
 
 void Session::DoWrite() {
+  if (TraceRecorder::IsRecording()) {
+    write_begin_usec_ = Clock::GetMicros();
+  }
+  OutboundMessage front;
+  {
+    boost::lock_guard<boost::detail::spinlock> lock{write_lock_};
+    front = write_msgs_.front();
+  }
   auto self(shared_from_this());
   boost::asio::async_write(
-      socket_,
-      boost::asio::buffer(write_msgs_.front().data(),
-                          write_msgs_.front().length()),
-      [this, self](boost::system::error_code ec, std::size_t /*length*/) {
+      socket_, boost::asio::buffer(front.msg->data(), front.msg->length()),
+      [this, self, front](boost::system::error_code ec, std::size_t length) {
         if (!ec) {
-          write_msgs_.pop_front();
-          if (!write_msgs_.empty()) {
+          Metrics::AddOutboundFrame(length);
+          if (TraceRecorder::IsRecording() and write_begin_usec_ != 0) {
+            TraceRecorder::AddSocketIo("Write", session_id_, length,
+                                       write_begin_usec_,
+                                       Clock::GetMicros());
+          }
+          write_begin_usec_ = 0;
+          Metrics::AddOutboundMessage(front.msg->msg_type());
+          Trace::End(front.trace);
+          bool has_next = false;
+          {
+            boost::lock_guard<boost::detail::spinlock> lock{write_lock_};
+            write_bytes_ -= front.msg->length();
+            if (write_bytes_ <= SESSION_OUTBOUND_LIMIT_BYTES / 2) {
+              over_limit_msec_ = 0;
+            }
+            write_msgs_.pop_front();
+            has_next = not write_msgs_.empty();
+          }
+          if (has_next) {
             DoWrite();
           }
         } else {
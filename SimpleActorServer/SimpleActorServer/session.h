@@ -1,9 +1,26 @@
 #pragma once
 
 #include <boost/asio.hpp>
+#include <boost/smart_ptr/detail/spinlock.hpp>
+#include <atomic>
 #include <deque>
+#include <memory>
 
 #include "simple_message.h"
+#include "trace_context.h"
+
+class ActorBaseModel;
+
+//:
+//: what a session does once its queued frames pass
+//: SESSION_OUTBOUND_LIMIT_BYTES, only broadcasts are ever dropped
+//:
+enum class OutboundPolicy {
+  DROP_OLDEST,  // the oldest queued broadcasts make room
+  COALESCE,     // a sender's queued broadcast is replaced by its newer one
+  DISCONNECT,   // drops like DROP_OLDEST, closed when it hasn't caught up
+                // within SESSION_OUTBOUND_GRACE_MSEC
+};
 
 //:
 //: tcp socket session
@@ -15,12 +32,37 @@ class Session : public std::enable_shared_from_this<Session> {
 
   inline std::string GetSessionId() const { return session_id_; }
   inline const std::string GetMessage() const {
-    return std::string(read_msg_.body()).substr(0, read_msg_.body_length());
+    return std::string(read_msg_.body(), read_msg_.body_length());
   }
+  inline const SimpleMessage& GetReadMessage() const { return read_msg_; }
+
+  //: what the peer reads, JSON until a Hello asks for another one
+  inline Codec GetCodec() const { return codec_.load(); }
+  inline void SetCodec(const Codec codec) { codec_.store(codec); }
 
   void Start();
+
+  //: holds the next read until the actor's mailbox is drained back under
+  //: MAILBOX_LOW_WATERMARK, nothing happens while it isn't overloaded
+  void PauseReadFor(const std::shared_ptr<ActorBaseModel>& actor);
+  //: true while some actor PauseReadFor() waited on is still overloaded
+  bool IsReadPaused() const;
+
+  //: safe from any thread, frames go out in the order they were queued
   void SendMessage(const SimpleMessage& msg);
+  void SendMessage(std::shared_ptr<const SimpleMessage> msg);
+  //: a frame the peer may miss when it falls behind, see OutboundPolicy
+  //: an empty sender marks a frame of several senders that never coalesces
+  void SendBroadcast(std::shared_ptr<const SimpleMessage> msg,
+                     const std::string& sender);
 
+  static void SetOutboundPolicy(const OutboundPolicy policy);
+  static OutboundPolicy GetOutboundPolicy();
+
+  //: {result} ack, a pre-encoded frame when there is one (response_frame.h)
+  static void SendResultMessage(const std::shared_ptr<Session>&,
+                                const MessageType msg_type,
+                                const ResultType result_type);
   static void SendErrorMessage(const std::shared_ptr<Session>&,
                                const MessageType msg_type,
                                const ResultType result_type);
@@ -28,11 +70,43 @@ class Session : public std::enable_shared_from_this<Session> {
  private:
   const std::string session_id_;
   boost::asio::ip::tcp::socket socket_;
+  std::atomic<Codec> codec_;
   SimpleMessage read_msg_;
+  std::shared_ptr<TraceContext> read_trace_;
+  int64_t read_begin_usec_;
+  int64_t write_begin_usec_;
+
+  // overloaded mailboxes this session waits for, the read parks meanwhile
+  mutable boost::detail::spinlock read_lock_ = BOOST_DETAIL_SPINLOCK_INIT;
+  int read_holds_;
+  bool is_read_parked_;
 
-  std::deque<SimpleMessage> write_msgs_;
+  struct OutboundMessage {
+    std::shared_ptr<const SimpleMessage> msg;
+    std::shared_ptr<TraceContext> trace;
+    bool is_broadcast;
+    std::string sender;
+  };
+  // actors queue, the io thread pops. the front stays queued while written
+  boost::detail::spinlock write_lock_ = BOOST_DETAIL_SPINLOCK_INIT;
+  std::deque<OutboundMessage> write_msgs_;
+  size_t write_bytes_;
+  // set when the queue reaches SESSION_OUTBOUND_LIMIT_BYTES, cleared once
+  // writes bring it down to half of it
+  int64_t over_limit_msec_;
+  // OutboundPolicy::DISCONNECT, only touched from the io threads while
+  // is_grace_armed_ is set
+  boost::asio::steady_timer grace_timer_;
+  bool is_grace_armed_;
+  bool is_disconnecting_;
 
+  void Enqueue(OutboundMessage&& outbound);
+  bool MakeRoom(const OutboundMessage& outbound, bool* is_grace_started);
+  void WaitForGrace(const int64_t delay_msec);
+  void Disconnect();
   void OnClosed();
+  void ContinueRead();
+  void ResumeRead();
   void DoReadHeader();
   void DoReadBody();
   void DoWrite();
@@ -0,0 +1,171 @@
+#include "session_capture.h"
+
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include "clock.h"
+#include "logger.h"
+#include "message_envelope.h"
+#include "messages.h"
+#include "utility.h"
+
+namespace {
+
+const char FILE_MAGIC[] = "SACAP001";
+const char CHAT_KEY[] = "\"chat_message\":\"";
+const uint8_t RECORD_FRAME = 1;
+const uint8_t RECORD_CLOSE = 2;
+const uint8_t BINARY_MARKER = 0x92;  // first byte of a Codec::BINARY body
+
+std::atomic<bool> capturing{false};
+
+// file writes happen under the lock, so it's a mutex instead of a spinlock
+boost::mutex capture_lock;
+std::ofstream out;
+std::string buffer;
+bool scrub;
+int64_t last_usec;
+std::unordered_map<std::string, uint32_t> connections;
+uint64_t frame_count;
+
+void PutVarint(uint64_t v) {
+  while (v >= 0x80) {
+    buffer += static_cast<char>((v & 0x7f) | 0x80);
+    v >>= 7;
+  }
+  buffer += static_cast<char>(v);
+}
+
+void PutRecordHeader(const uint8_t kind, const std::string& session_id) {
+  const auto it =
+      connections
+          .emplace(session_id, static_cast<uint32_t>(connections.size()))
+          .first;
+  const int64_t now_usec = Clock::GetMicros();
+  buffer += static_cast<char>(kind);
+  PutVarint(it->second);
+  PutVarint(static_cast<uint64_t>(now_usec - last_usec));
+  last_usec = now_usec;
+}
+
+void Flush() {
+  out.write(buffer.data(), buffer.size());
+  buffer.clear();
+}
+
+//: a BINARY SendChat is [107, [chat_message]], the text ends the frame
+void ScrubBinaryChat(const size_t body_offset) {
+  MessageEnvelope envelope;
+  Protocol::SendChat chat;
+  const auto result = Envelope::Parse(
+      buffer.data() + body_offset, buffer.size() - body_offset,
+      [](const int msg_type) {
+        return msg_type == static_cast<int>(MessageType::SendChat);
+      },
+      &envelope);
+  if (result != Envelope::Result::OK or
+      not MessageBody(envelope).Decode(&chat)) {
+    return;
+  }
+  std::fill(buffer.end() - chat.chat_message.size(), buffer.end(), 'x');
+}
+
+//: overwrites the chat text with 'x', the frame keeps its length
+void ScrubChat(const size_t body_offset) {
+  if (body_offset < buffer.size() and
+      static_cast<uint8_t>(buffer[body_offset]) == BINARY_MARKER) {
+    ScrubBinaryChat(body_offset);
+    return;
+  }
+  const char* body = buffer.data() + body_offset;
+  const char* key = std::strstr(body, CHAT_KEY);
+  if (key == nullptr) {
+    return;
+  }
+  for (size_t i = key - buffer.data() + sizeof(CHAT_KEY) - 1;
+       i < buffer.size() and buffer[i] != '"'; ++i) {
+    if (buffer[i] == '\\' and i + 1 < buffer.size()) {
+      buffer[i++] = 'x';
+    }
+    buffer[i] = 'x';
+  }
+}
+
+}  // namespace
+
+bool SessionCapture::Start(const std::string& path, const bool scrub_chat) {
+  boost::lock_guard<boost::mutex> lock{capture_lock};
+  if (capturing.load()) {
+    Log::Print(Log::Level::WARNING, "SessionCapture: already capturing");
+    return false;
+  }
+
+  out.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+  if (not out) {
+    Log::Print(Log::Level::ERROR_, "SessionCapture::Start(): can't open " +
+                                       path);
+    return false;
+  }
+  buffer.assign(FILE_MAGIC, sizeof(FILE_MAGIC) - 1);
+  scrub = scrub_chat;
+  last_usec = Clock::GetMicros();
+  connections.clear();
+  frame_count = 0;
+  capturing.store(true);
+
+  Log::Print(Log::Level::INFO, "SessionCapture: capturing to " + path +
+                                   (scrub ? " (chat scrubbed)" : ""));
+  return true;
+}
+
+void SessionCapture::Stop() {
+  boost::lock_guard<boost::mutex> lock{capture_lock};
+  if (not capturing.load()) {
+    return;
+  }
+  capturing.store(false);
+  Flush();
+  out.close();
+
+  Log::Print(Log::Level::INFO,
+             "SessionCapture: stopped, " + std::to_string(frame_count) +
+                 " frames of " + std::to_string(connections.size()) +
+                 " connections");
+}
+
+bool SessionCapture::IsCapturing() {
+  return capturing.load(std::memory_order_relaxed);
+}
+
+void SessionCapture::AddFrame(const std::string& session_id, const char* body,
+                              const size_t length) {
+  boost::lock_guard<boost::mutex> lock{capture_lock};
+  if (not capturing.load()) {
+    return;
+  }
+  PutRecordHeader(RECORD_FRAME, session_id);
+  PutVarint(length);
+  const size_t body_offset = buffer.size();
+  buffer.append(body, length);
+  if (scrub) {
+    ScrubChat(body_offset);
+  }
+  ++frame_count;
+
+  if (buffer.size() >= SESSION_CAPTURE_FLUSH_BYTES) {
+    Flush();
+  }
+}
+
+void SessionCapture::AddClose(const std::string& session_id) {
+  boost::lock_guard<boost::mutex> lock{capture_lock};
+  if (not capturing.load() or connections.count(session_id) == 0) {
+    return;
+  }
+  PutRecordHeader(RECORD_CLOSE, session_id);
+}
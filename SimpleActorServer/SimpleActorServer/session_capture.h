@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+//:
+//: records inbound frames of every session for DummyClient --replay
+//:
+//: file: "SACAP001", then one record after another
+//:   u8 kind (1 frame, 2 close), varint connection, varint usec since the
+//:   previous record, frame only: varint body length + the body as read,
+//:   JSON or BINARY
+//: connections are numbered from 0 in the order they are first seen
+//:
+namespace SessionCapture {
+
+bool Start(const std::string& path, const bool scrub_chat);
+void Stop();
+bool IsCapturing();
+
+void AddFrame(const std::string& session_id, const char* body,
+              const size_t length);
+void AddClose(const std::string& session_id);
+
+}  // namespace SessionCapture
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -35,6 +36,23 @@ enum class MessageType {
   SendChat,
   SendChatAck,
   BroadcastingChat,
+  Hello,
+  HelloAck,
+  BroadcastingChatBatch,
+
+  EndOfMessage,
+};
+
+//:
+//: body encoding of a frame, the header stays 4 ascii digits for both
+//: JSON     {"msg_type":N,"msg_body":{...}}
+//: BINARY   MessagePack [N, [fields...]], see messages.h
+//: a session sends JSON until a Hello negotiates BINARY, frames are read
+//: in either one since the first byte tells them apart
+//:
+enum class Codec {
+  JSON,
+  BINARY,
 };
 
 class SimpleMessage {
@@ -42,7 +60,9 @@ class SimpleMessage {
   enum { header_length = 4 };
   enum { max_body_length = 512 };
 
-  SimpleMessage() : body_length_(0) { memset(data_, 0, sizeof(data_)); }
+  SimpleMessage() : body_length_(0), msg_type_(0) {
+    memset(data_, 0, sizeof(data_));
+  }
 
   const char* data() const { return data_; }
 
@@ -56,14 +76,17 @@ class SimpleMessage {
 
   std::size_t body_length() const { return body_length_; }
 
+  int msg_type() const { return msg_type_; }
+
   void body_length(std::size_t new_length) {
     body_length_ = new_length;
     if (body_length_ > max_body_length) body_length_ = max_body_length;
   }
 
   bool decode_header() {
-    char header[header_length + 1] = "";
-    std::strncat(header, data_, header_length);
+    char header[header_length + 1];
+    std::memcpy(header, data_, header_length);
+    header[header_length] = '\0';
     body_length_ = std::atoi(header);
     if (body_length_ > max_body_length) {
       body_length_ = 0;
@@ -78,22 +101,86 @@ class SimpleMessage {
     std::memcpy(data_, header, header_length);
   }
 
+  //:
+  //: {"msg_type":N,"msg_body":doc}, the envelope is written around the
+  //: serialized body instead of copying doc into another document
+  //:
   static SimpleMessage MakeMessage(const int msg_type, const Json& doc) {
-    Json res_doc;
-    res_doc.SetObject();
-    res_doc.SetAttribute("msg_type", msg_type);
-    res_doc.SetAttribute("msg_body", doc);
+    const rapidjson::StringBuffer& body = Json::Serialize(doc);
 
     SimpleMessage msg;
-    std::string str_res = res_doc.ToString();
-    msg.body_length(str_res.size());
-    std::memcpy(msg.body(), str_res.c_str(), msg.body_length());
+    std::size_t length =
+        std::snprintf(msg.body(), max_body_length,
+                      "{\"msg_type\":%d,\"msg_body\":", msg_type);
+    const std::size_t body_size =
+        std::min(body.GetSize(), max_body_length - length);
+    std::memcpy(msg.body() + length, body.GetString(), body_size);
+    length += body_size;
+    if (length < max_body_length) {
+      msg.body()[length++] = '}';
+    }
+    msg.body_length(length);
     msg.encode_header();
+    msg.msg_type_ = msg_type;
+
+    return msg;
+  }
+
+  //:
+  //: typed message from messages.h, the body is encoded straight into the
+  //: frame. one that doesn't fit leaves an empty frame the peer rejects
+  //:
+  template <typename T>
+  static SimpleMessage MakeMessage(const T& doc,
+                                   const Codec codec = Codec::JSON) {
+    return MakeMessage(static_cast<int>(T::TYPE), doc, codec);
+  }
+
+  //: same as above for a body shared by several message types
+  template <typename T>
+  static SimpleMessage MakeMessage(const int msg_type, const T& doc,
+                                   const Codec codec) {
+    SimpleMessage msg;
+    std::size_t length = 0;
+    std::size_t body_size = 0;
+    if (codec == Codec::BINARY) {
+      length = EncodeBinaryPrefix(msg.body(), msg_type);
+      body_size =
+          doc.EncodeBinary(msg.body() + length, max_body_length - length);
+    } else {
+      length = std::snprintf(msg.body(), max_body_length,
+                             "{\"msg_type\":%d,\"msg_body\":", msg_type);
+      // one byte stays free for the closing brace
+      body_size =
+          doc.EncodeJson(msg.body() + length, max_body_length - length - 1);
+      if (body_size != 0) {
+        msg.body()[length + body_size++] = '}';
+      }
+    }
+    length = (body_size == 0) ? 0 : length + body_size;
+    msg.body_length(length);
+    msg.encode_header();
+    msg.msg_type_ = msg_type;
 
     return msg;
   }
 
  private:
+  //: 2 element array marker and msg_type as a positive fixint or uint16
+  static std::size_t EncodeBinaryPrefix(char* body, const int msg_type) {
+    std::size_t length = 0;
+    body[length++] = static_cast<char>(0x92);
+    if (msg_type >= 0 && msg_type <= 0x7f) {
+      body[length++] = static_cast<char>(msg_type);
+    } else {
+      body[length++] = static_cast<char>(0xcd);
+      body[length++] = static_cast<char>((msg_type >> 8) & 0xff);
+      body[length++] = static_cast<char>(msg_type & 0xff);
+    }
+    return length;
+  }
+
   char data_[header_length + max_body_length];
   std::size_t body_length_;
+  int msg_type_;
 };
@@ -6,17 +6,22 @@
 #include <mutex>
 #include <unordered_map>
 
+#include "clock.h"
 #include "logger.h"
+#include "metrics.h"
+#include "trace_recorder.h"
 
 namespace {
 
 boost::detail::spinlock profiling_lock;
-const int64_t start_ts = Utility::GetMillisTimestampFromNow();
+const int64_t start_ts = Clock::GetMillis();
 uint64_t counter = 0;
 uint64_t max_execution_ts = 0;
 uint64_t min_execution_ts = UINT64_MAX;
 double avr_execution_ts = 0.0f;
 
+thread_local void* current_worker_slot = nullptr;
+
 void UpdateStatus(const uint64_t ts) {
   boost::lock_guard<boost::detail::spinlock> lock{profiling_lock};
   ++counter;
@@ -33,7 +38,10 @@ void UpdateStatus(const uint64_t ts) {
 std::once_flag ThreadPoolManager::once_flag_;
 std::shared_ptr<ThreadPoolManager> ThreadPoolManager::instance_ = nullptr;
 
-ThreadPoolManager::ThreadPoolManager() {}
+ThreadPoolManager::ThreadPoolManager()
+    : is_affinity_(THREAD_POOL_AFFINITY),
+      local_activations_(0),
+      migrated_activations_(0) {}
 
 ThreadPoolManager::~ThreadPoolManager() {
   Stop();
@@ -45,10 +53,17 @@ void ThreadPoolManager::Initialize(const size_t thread_count) {
     return;
   }
 
+  if (worker_slots_.empty()) {
+    worker_slots_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+      worker_slots_.emplace_back(std::make_unique<WorkerSlot>());
+    }
+  }
+
   threads_.reserve(thread_count);
   for (size_t i = 0; i < thread_count; ++i) {
-    threads_.emplace_back(
-        std::make_unique<boost::thread>([this]() { this->RunThread(); }));
+    threads_.emplace_back(std::make_unique<boost::thread>(
+        [this, i]() { this->RunThread(i); }));
   }
 }
 
@@ -66,30 +81,142 @@ void ThreadPoolManager::Stop() {
 
 void ThreadPoolManager::PushTask(const std::function<void()>& task) {
   task_queue_.Enqueue(task);
+  WakeIdleWorker();
+}
+
+void ThreadPoolManager::PushTask(const std::function<void()>& task,
+                                 const size_t affinity_key) {
+  if (not is_affinity_.load() or worker_slots_.empty()) {
+    PushTask(task);
+    return;
+  }
+
+  // an overloaded home worker hands the activation to whoever is free
+  auto& home = worker_slots_[affinity_key % worker_slots_.size()];
+  if (home->task_queue.Size() >= THREAD_POOL_AFFINITY_OVERLOAD) {
+    migrated_activations_.fetch_add(1, std::memory_order_relaxed);
+    PushTask(task);
+    return;
+  }
+  home->task_queue.Enqueue(task);
+  if (home->is_idle.load()) {
+    boost::lock_guard<boost::mutex> lock{home->idle_mutex};
+    home->idle_cv.notify_one();
+  }
+}
+
+size_t ThreadPoolManager::GetQueueSize() {
+  size_t size = task_queue_.Size();
+  for (auto& slot : worker_slots_) {
+    size += slot->task_queue.Size();
+  }
+  return size;
 }
 
 ThreadStatus ThreadPoolManager::GetStatus() {
   boost::lock_guard<boost::detail::spinlock> lock{profiling_lock};
-  const int64_t running_time = Utility::GetMillisTimestampFromNow() - start_ts;
+  const int64_t running_time = Clock::GetMillis() - start_ts;
   const int64_t tps = counter;
   counter = 0;
   return ThreadStatus(running_time, tps, max_execution_ts, min_execution_ts,
-                      avr_execution_ts, task_queue_.Size());
+                      avr_execution_ts, GetQueueSize());
 }
 
-void ThreadPoolManager::RunThread() {
+std::vector<WorkerStatus> ThreadPoolManager::GetWorkerStatus() {
+  std::vector<WorkerStatus> status;
+  status.reserve(worker_slots_.size());
+  for (size_t i = 0; i < worker_slots_.size(); ++i) {
+    auto& slot = worker_slots_[i];
+    WorkerStatus worker;
+    worker.worker_index = i;
+    worker.task_begin_msec = slot->task_begin_msec.load();
+    {
+      boost::lock_guard<boost::detail::spinlock> lock{slot->actor_lock};
+      worker.actor = slot->actor.lock();
+    }
+    status.emplace_back(std::move(worker));
+  }
+  return status;
+}
+
+ActivationStatus ThreadPoolManager::GetActivationStatus() const {
+  ActivationStatus status;
+  status.local = local_activations_.load(std::memory_order_relaxed);
+  status.migrated = migrated_activations_.load(std::memory_order_relaxed);
+  return status;
+}
+
+void ThreadPoolManager::SetCurrentActor(
+    const std::shared_ptr<ActorBaseModel>& actor) {
+  auto slot = static_cast<WorkerSlot*>(current_worker_slot);
+  if (slot == nullptr) {
+    return;
+  }
+  boost::lock_guard<boost::detail::spinlock> lock{slot->actor_lock};
+  slot->actor = actor;
+}
+
+void ThreadPoolManager::WakeIdleWorker() {
+  // the worker sets is_idle before it looks at the shared queue a last
+  // time, so either it sees the task or it is found here
+  for (auto& slot : worker_slots_) {
+    if (slot->is_idle.load()) {
+      boost::lock_guard<boost::mutex> lock{slot->idle_mutex};
+      slot->idle_cv.notify_one();
+      return;
+    }
+  }
+}
+
+bool ThreadPoolManager::StealTask(const size_t index,
+                                  std::function<void()>* task) {
+  // an idle worker is woken for its own actors, only a busy one is robbed
+  for (size_t i = 1; i < worker_slots_.size(); ++i) {
+    auto& victim = worker_slots_[(index + i) % worker_slots_.size()];
+    if (victim->task_begin_msec.load() != 0 and
+        not victim->task_queue.IsEmpty() and
+        victim->task_queue.TryDequeue(task)) {
+      migrated_activations_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPoolManager::RunThread(const size_t index) {
+  TraceRecorder::SetThreadName("ThreadPoolManager");
+  WorkerSlot* slot = worker_slots_[index].get();
+  current_worker_slot = slot;
   try {
     std::function<void()> task = nullptr;
 
     while (true) {
       boost::this_thread::interruption_point();
-      if (task_queue_.TryDequeue(&task)) {
-        uint64_t pre_ts = Utility::GetMillisTimestampFromNow();
+      // home actors first, then the shared queue, then other workers' homes
+      bool has_task = false;
+      if (slot->task_queue.TryDequeue(&task)) {
+        local_activations_.fetch_add(1, std::memory_order_relaxed);
+        has_task = true;
+      } else {
+        has_task = task_queue_.TryDequeue(&task) or StealTask(index, &task);
+      }
+      if (has_task) {
+        uint64_t pre_ts = Clock::GetMillis();
+        slot->task_begin_msec.store(pre_ts);
         task();
-        uint64_t now_ts = Utility::GetMillisTimestampFromNow();
+        slot->task_begin_msec.store(0);
+        uint64_t now_ts = Clock::GetMillis();
         UpdateStatus(now_ts - pre_ts);
+        Metrics::ObserveTask(now_ts - pre_ts);
       } else {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        // a home push wakes this worker, a shared push one idle worker,
+        // other workers' homes are still polled
+        boost::unique_lock<boost::mutex> lock{slot->idle_mutex};
+        slot->is_idle.store(true);
+        if (slot->task_queue.IsEmpty() and task_queue_.IsEmpty()) {
+          slot->idle_cv.wait_for(lock, boost::chrono::milliseconds(100));
+        }
+        slot->is_idle.store(false);
       }
     }
   } catch (...) {
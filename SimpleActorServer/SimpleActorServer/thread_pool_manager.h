@@ -1,6 +1,8 @@
 #pragma once
 
+#include <boost/smart_ptr/detail/spinlock.hpp>
 #include <boost/thread.hpp>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -8,6 +10,8 @@
 #include "concurrent_queue.h"
 #include "utility.h"
 
+class ActorBaseModel;
+
 //:
 //: monitoring status ü
 //:
@@ -28,6 +32,25 @@ struct ThreadStatus {
   size_t queue_size;
 };
 
+//:
+//: worker snapshot for the watchdog
+//:
+struct WorkerStatus {
+  size_t worker_index;
+  int64_t task_begin_msec;  // 0 when idle
+  std::shared_ptr<ActorBaseModel> actor;
+};
+
+//:
+//: activations of actors with a home worker, monotonic
+//: local ran on the home worker, migrated ran elsewhere because the home
+//: queue was over THREAD_POOL_AFFINITY_OVERLOAD or another worker stole it
+//:
+struct ActivationStatus {
+  uint64_t local;
+  uint64_t migrated;
+};
+
 //:
 //: ConcurrentQueue + Thread Pool
 //:
@@ -56,12 +79,39 @@ class ThreadPoolManager {
  public:
   void Stop();
   void PushTask(const std::function<void()>& task);
+  //: runs the task on the worker affinity_key maps to when affinity is on
+  void PushTask(const std::function<void()>& task, const size_t affinity_key);
+  size_t GetQueueSize();
+
+  void SetAffinity(const bool is_enabled) { is_affinity_ = is_enabled; }
+  bool IsAffinity() const { return is_affinity_.load(); }
 
   ThreadStatus GetStatus();
+  std::vector<WorkerStatus> GetWorkerStatus();
+  ActivationStatus GetActivationStatus() const;
+
+  static void SetCurrentActor(const std::shared_ptr<ActorBaseModel>& actor);
 
  private:
+  struct WorkerSlot {
+    WorkerSlot() : task_begin_msec(0) {}
+    std::atomic<int64_t> task_begin_msec;
+    boost::detail::spinlock actor_lock = BOOST_DETAIL_SPINLOCK_INIT;
+    std::weak_ptr<ActorBaseModel> actor;
+    ConcurrentQueue<std::function<void()>> task_queue;  // home actors
+    std::atomic<bool> is_idle{false};
+    boost::mutex idle_mutex;
+    boost::condition_variable idle_cv;
+  };
+
+  std::atomic<bool> is_affinity_;
+  std::atomic<uint64_t> local_activations_;
+  std::atomic<uint64_t> migrated_activations_;
   ConcurrentQueue<std::function<void()>> task_queue_;
   std::vector<std::unique_ptr<boost::thread>> threads_;
+  std::vector<std::unique_ptr<WorkerSlot>> worker_slots_;
 
-  void RunThread();
+  void RunThread(const size_t index);
+  void WakeIdleWorker();
+  bool StealTask(const size_t index, std::function<void()>* task);
 };
@@ -1,7 +1,12 @@
 #include "timer_event_manager.h"
 
+#include <algorithm>
+
 #include "actor_base_model.h"
+#include "clock.h"
 #include "logger.h"
+#include "metrics.h"
+#include "trace_recorder.h"
 #include "utility.h"
 
 TimerEventWorker::TimerEventWorker()
@@ -16,12 +21,13 @@ TimerEventWorker::~TimerEventWorker() {
 }
 
 void TimerEventWorker::RunThread() {
+  TraceRecorder::SetThreadName("TimerEventWorker");
   try {
     while (true) {
       boost::this_thread::interruption_point();
       MakePendingTimerEvent();
       ExecuteTimerEvent();
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      TimerEventManager::GetInstance()->WaitForEvent(GetWaitMsec());
     }
   } catch (...) {
     Log::Print(Log::Level::INFO, "TimerEventManager Interrupted Thread");
@@ -47,38 +53,49 @@ void TimerEventWorker::MakePendingTimerEvent() {
 }
 
 void TimerEventWorker::ExecuteTimerEvent() {
-  const int64_t now_msec = Utility::GetMillisTimestampFromNow();
-
-  std::vector<int64_t> removal_keys;
-  removal_keys.reserve(event_queue_by_timestamp_.size());
-
-  for (auto& entry : event_queue_by_timestamp_) {
-    const int64_t expected_msec = entry.first;
-    if (now_msec < expected_msec) {
-      continue;
-    }
-
-    auto& queue = entry.second;
+  const int64_t now_msec = Clock::GetMillis();
+  const bool is_recording = TraceRecorder::IsRecording();
+  const int64_t begin_usec = is_recording ? Clock::GetMicros() : 0;
+  int64_t fired_count = 0;
+
+  // ordered by time, only the due ones are visited
+  auto iter = event_queue_by_timestamp_.begin();
+  while (iter != event_queue_by_timestamp_.end() and
+         iter->first <= now_msec) {
+    auto& queue = iter->second;
+    Metrics::AddPendingTimer(-static_cast<int64_t>(queue.size()));
+    Metrics::AddFiredTimer(queue.size());
+    fired_count += queue.size();
     while (not queue.empty()) {
       auto& info = queue.front();
       info.actor->AsyncTask(info.task);
       queue.pop();
     }
 
-    removal_keys.emplace_back(expected_msec);
+    iter = event_queue_by_timestamp_.erase(iter);
   }
 
-  for (const int64_t key : removal_keys) {
-    event_queue_by_timestamp_.erase(key);
+  if (is_recording and fired_count > 0) {
+    TraceRecorder::AddTimerBatch(fired_count, begin_usec,
+                                 Clock::GetMicros());
   }
 }
 
+int64_t TimerEventWorker::GetWaitMsec() const {
+  if (event_queue_by_timestamp_.empty()) {
+    return TIMER_EVENT_IDLE_MSEC;
+  }
+  const int64_t wait_msec =
+      event_queue_by_timestamp_.begin()->first - Clock::GetMillis();
+  return std::max<int64_t>(std::min(wait_msec, TIMER_EVENT_IDLE_MSEC), 0);
+}
+
 //----------------------------------------------------------------------
 
 std::once_flag TimerEventManager::once_flag_;
 std::shared_ptr<TimerEventManager> TimerEventManager::instance_ = nullptr;
 
-TimerEventManager::TimerEventManager() {}
+TimerEventManager::TimerEventManager() : has_event_(false) {}
 
 TimerEventManager::~TimerEventManager() {
   for (auto& worker : timer_event_workers_) {
@@ -107,11 +124,25 @@ void TimerEventManager::InvokeEvent(
   TimerEventInfo info;
   info.actor = actor;
   info.task = task;
-  info.expected_msec = Utility::GetMillisTimestampFromNow() + delay_msec;
+  info.expected_msec = Clock::GetMillis() + delay_msec;
 
   event_queue_.Enqueue(info);
+  Metrics::AddPendingTimer(1);
+
+  {
+    boost::lock_guard<boost::mutex> lock{wait_mutex_};
+    has_event_ = true;
+  }
+  wait_cv_.notify_one();
 }
 
 bool TimerEventManager::GetEventInfo(TimerEventInfo* info) {
   return event_queue_.TryDequeue(info);
+}
+
+void TimerEventManager::WaitForEvent(const int64_t wait_msec) {
+  boost::unique_lock<boost::mutex> lock{wait_mutex_};
+  wait_cv_.wait_for(lock, boost::chrono::milliseconds(wait_msec),
+                    [this]() { return has_event_; });
+  has_event_ = false;
 }
\ No newline at end of file
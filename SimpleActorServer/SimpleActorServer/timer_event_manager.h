@@ -2,9 +2,9 @@
 
 #include <boost/thread.hpp>
 #include <functional>
+#include <map>
 #include <memory>
 #include <queue>
-#include <unordered_map>
 #include <vector>
 
 #include "concurrent_queue.h"
@@ -31,15 +31,16 @@ class TimerEventWorker {
   ~TimerEventWorker();
 
  private:
-  using EventQeueHashMap =
-      std::unordered_map<int64_t, std::queue<TimerEventInfo>>;
+  using EventQueueMap = std::map<int64_t, std::queue<TimerEventInfo>>;
 
-  EventQeueHashMap event_queue_by_timestamp_;
+  EventQueueMap event_queue_by_timestamp_;
   std::unique_ptr<boost::thread> thread_;
 
   void RunThread();
   void MakePendingTimerEvent();
   void ExecuteTimerEvent();
+  //: until the earliest pending event, TIMER_EVENT_IDLE_MSEC at most
+  int64_t GetWaitMsec() const;
 };
 
 //:
@@ -71,8 +72,14 @@ class TimerEventManager {
   void InvokeEvent(const std::shared_ptr<ActorBaseModel>& actor,
                    const std::function<void()>& task, const int64_t delay_msec);
   bool GetEventInfo(TimerEventInfo* info);
+  //: returns early once InvokeEvent() queued an event, the worker that
+  //: wakes takes every queued one
+  void WaitForEvent(const int64_t wait_msec);
 
  private:
   std::vector<std::unique_ptr<TimerEventWorker>> timer_event_workers_;
   ConcurrentQueue<TimerEventInfo> event_queue_;
+  boost::mutex wait_mutex_;
+  boost::condition_variable wait_cv_;
+  bool has_event_;
 };
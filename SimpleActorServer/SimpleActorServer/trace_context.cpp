@@ -0,0 +1,96 @@
+#include "trace_context.h"
+
+#include <atomic>
+
+#include "clock.h"
+#include "metrics.h"
+#include "utility.h"
+
+namespace {
+
+std::atomic<uint32_t> sample_rate{TRACE_SAMPLE_RATE};
+thread_local uint32_t sample_countdown = 0;
+thread_local std::shared_ptr<TraceContext> current_trace;
+
+const char* STAGE_NAMES[] = {
+    "socket_read",  "parse",        "user_mailbox", "room_mailbox",
+    "fan_out",      "socket_write", "end_to_end",
+};
+
+}  // namespace
+
+void Trace::SetSampleRate(const uint32_t rate) {
+  sample_rate.store(rate, std::memory_order_relaxed);
+}
+
+const char* Trace::GetStageName(const TraceStage stage) {
+  return STAGE_NAMES[static_cast<int>(stage)];
+}
+
+std::shared_ptr<TraceContext> Trace::Begin() {
+  const uint32_t rate = sample_rate.load(std::memory_order_relaxed);
+  if (rate == 0) {
+    return nullptr;
+  }
+  if (sample_countdown > 0) {
+    --sample_countdown;
+    return nullptr;
+  }
+  sample_countdown = rate - 1;
+
+  auto trace = std::make_shared<TraceContext>();
+  trace->msg_type = 0;
+  trace->start_usec = Clock::GetMicros();
+  trace->last_usec = trace->start_usec;
+  return trace;
+}
+
+void Trace::SetMessageType(const std::shared_ptr<TraceContext>& trace,
+                           const int msg_type) {
+  if (not trace) {
+    return;
+  }
+  // the socket read is marked before the frame is parsed
+  trace->msg_type = msg_type;
+  Metrics::ObserveTraceStage(msg_type, TraceStage::SOCKET_READ,
+                             trace->last_usec - trace->start_usec);
+}
+
+std::shared_ptr<TraceContext> Trace::Fork(
+    const std::shared_ptr<TraceContext>& trace) {
+  if (not trace) {
+    return nullptr;
+  }
+  return std::make_shared<TraceContext>(*trace);
+}
+
+void Trace::Mark(const std::shared_ptr<TraceContext>& trace,
+                 const TraceStage stage) {
+  if (not trace) {
+    return;
+  }
+  const int64_t now_usec = Clock::GetMicros();
+  if (trace->msg_type != 0) {
+    Metrics::ObserveTraceStage(trace->msg_type, stage,
+                               now_usec - trace->last_usec);
+  }
+  trace->last_usec = now_usec;
+}
+
+void Trace::End(const std::shared_ptr<TraceContext>& trace) {
+  if (not trace) {
+    return;
+  }
+  Mark(trace, TraceStage::SOCKET_WRITE);
+  Metrics::ObserveTraceStage(trace->msg_type, TraceStage::END_TO_END,
+                             trace->last_usec - trace->start_usec);
+}
+
+const std::shared_ptr<TraceContext>& Trace::Current() { return current_trace; }
+
+Trace::Scope::Scope(const std::shared_ptr<TraceContext>& trace)
+    : prev_(std::move(current_trace)) {
+  current_trace = trace;
+}
+
+Trace::Scope::~Scope() { current_trace = std::move(prev_); }
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+//:
+//: message path checkpoints, each stage is measured from the previous one
+//:
+enum class TraceStage {
+  SOCKET_READ = 0,  // header read -> body read
+  PARSE,            // body read -> handler lookup
+  USER_MAILBOX,     // user actor enqueue -> handler start
+  ROOM_MAILBOX,     // room actor enqueue -> room task start
+  FAN_OUT,          // room shard enqueue -> shard task start
+  SOCKET_WRITE,     // Session::SendMessage -> write completion
+  END_TO_END,       // header read -> write completion
+  COUNT,
+};
+
+//:
+//: sampled per-message trace, owned by one branch of the message path
+//: a branch that splits (ack + room event, room fan-out) forks a copy
+//:
+struct TraceContext {
+  int msg_type;
+  int64_t start_usec;
+  int64_t last_usec;
+};
+
+namespace Trace {
+
+void SetSampleRate(const uint32_t rate);
+const char* GetStageName(const TraceStage stage);
+
+std::shared_ptr<TraceContext> Begin();
+void SetMessageType(const std::shared_ptr<TraceContext>& trace,
+                    const int msg_type);
+std::shared_ptr<TraceContext> Fork(const std::shared_ptr<TraceContext>& trace);
+void Mark(const std::shared_ptr<TraceContext>& trace, const TraceStage stage);
+void End(const std::shared_ptr<TraceContext>& trace);
+
+const std::shared_ptr<TraceContext>& Current();
+
+//:
+//: makes a trace the current one of this thread while a handler runs
+//:
+class Scope {
+ public:
+  Scope(const std::shared_ptr<TraceContext>& trace);
+  ~Scope();
+
+ private:
+  std::shared_ptr<TraceContext> prev_;
+};
+
+}  // namespace Trace
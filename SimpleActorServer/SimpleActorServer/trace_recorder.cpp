@@ -0,0 +1,176 @@
+#include "trace_recorder.h"
+
+#include <boost/atomic.hpp>
+#include <boost/smart_ptr/detail/spinlock.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <atomic>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "clock.h"
+#include "logger.h"
+#include "utility.h"
+
+namespace {
+
+struct TraceEvent {
+  const char* name;
+  const char* category;
+  uint32_t tid;
+  int64_t ts_usec;
+  int64_t dur_usec;
+  const char* id_key;
+  std::string id;
+  const char* count_key;
+  int64_t count;
+};
+
+std::atomic<bool> recording{false};
+
+boost::detail::spinlock event_lock;
+std::vector<TraceEvent> events;
+size_t oldest_event = 0;
+
+boost::detail::spinlock thread_lock;
+std::vector<std::pair<uint32_t, std::string>> thread_names;
+std::atomic<uint32_t> next_tid{1};
+thread_local uint32_t current_tid = 0;
+
+uint32_t GetThreadTid() {
+  if (current_tid == 0) {
+    current_tid = next_tid.fetch_add(1);
+  }
+  return current_tid;
+}
+
+void AddEvent(TraceEvent&& event) {
+  boost::lock_guard<boost::detail::spinlock> lock{event_lock};
+  if (events.size() < TRACE_RECORDER_CAPACITY) {
+    events.emplace_back(std::move(event));
+    return;
+  }
+  events[oldest_event] = std::move(event);
+  oldest_event = (oldest_event + 1) % events.size();
+}
+
+std::string Escape(const std::string& v) {
+  std::string escaped;
+  escaped.reserve(v.size());
+  for (const char c : v) {
+    if (c == '"' or c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      escaped += ' ';
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+void WriteEvent(const TraceEvent& event, std::ofstream* out) {
+  *out << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+       << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.tid
+       << ",\"ts\":" << event.ts_usec << ",\"dur\":" << event.dur_usec
+       << ",\"args\":{";
+  if (event.id_key != nullptr) {
+    *out << "\"" << event.id_key << "\":\"" << Escape(event.id) << "\",";
+  }
+  *out << "\"" << event.count_key << "\":" << event.count << "}}";
+}
+
+}  // namespace
+
+void TraceRecorder::Start() {
+  {
+    boost::lock_guard<boost::detail::spinlock> lock{event_lock};
+    events.clear();
+    oldest_event = 0;
+  }
+  recording.store(true);
+  Log::Print(Log::Level::INFO, "TraceRecorder: start recording");
+}
+
+void TraceRecorder::Stop() {
+  recording.store(false);
+  Log::Print(Log::Level::INFO, "TraceRecorder: stop recording");
+}
+
+bool TraceRecorder::IsRecording() {
+  return recording.load(std::memory_order_relaxed);
+}
+
+bool TraceRecorder::Dump(const std::string& path) {
+  std::vector<TraceEvent> snapshot;
+  size_t oldest = 0;
+  {
+    boost::lock_guard<boost::detail::spinlock> lock{event_lock};
+    snapshot = events;
+    oldest = oldest_event;
+  }
+  std::vector<std::pair<uint32_t, std::string>> names;
+  {
+    boost::lock_guard<boost::detail::spinlock> lock{thread_lock};
+    names = thread_names;
+  }
+
+  std::ofstream out(path, std::ios::out | std::ios::trunc);
+  if (not out) {
+    Log::Print(Log::Level::ERROR_, "TraceRecorder::Dump(): can't open " + path);
+    return false;
+  }
+
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  bool first = true;
+  for (const auto& entry : names) {
+    out << (first ? "" : ",\n")
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << entry.first << ",\"args\":{\"name\":\"" << Escape(entry.second)
+        << "\"}}";
+    first = false;
+  }
+  for (size_t i = 0; i < snapshot.size(); ++i) {
+    out << (first ? "" : ",\n");
+    WriteEvent(snapshot[(oldest + i) % snapshot.size()], &out);
+    first = false;
+  }
+  out << "\n]}\n";
+
+  Log::Print(Log::Level::INFO, "TraceRecorder: dumped " +
+                                   std::to_string(snapshot.size()) +
+                                   " events to " + path);
+  return true;
+}
+
+void TraceRecorder::SetThreadName(const std::string& name) {
+  const uint32_t tid = GetThreadTid();
+  boost::lock_guard<boost::detail::spinlock> lock{thread_lock};
+  thread_names.emplace_back(tid, name);
+}
+
+void TraceRecorder::AddActivation(const char* actor_type,
+                                  const std::string& actor_id,
+                                  const int64_t message_count,
+                                  const int64_t begin_usec,
+                                  const int64_t end_usec) {
+  AddEvent({actor_type, "actor", GetThreadTid(), begin_usec,
+            end_usec - begin_usec, "actor_id", actor_id, "messages",
+            message_count});
+}
+
+void TraceRecorder::AddTimerBatch(const int64_t event_count,
+                                  const int64_t begin_usec,
+                                  const int64_t end_usec) {
+  AddEvent({"ExecuteTimerEvent", "timer", GetThreadTid(), begin_usec,
+            end_usec - begin_usec, nullptr, "", "events", event_count});
+}
+
+void TraceRecorder::AddSocketIo(const char* name,
+                                const std::string& session_id,
+                                const size_t bytes, const int64_t begin_usec,
+                                const int64_t end_usec) {
+  AddEvent({name, "asio", GetThreadTid(), begin_usec, end_usec - begin_usec,
+            "session_id", session_id, "bytes", static_cast<int64_t>(bytes)});
+}
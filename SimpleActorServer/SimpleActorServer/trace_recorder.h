@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+//:
+//: Chrome trace_event recorder (chrome://tracing, Perfetto)
+//: keeps the newest TRACE_RECORDER_CAPACITY events while recording
+//:
+namespace TraceRecorder {
+
+void Start();
+void Stop();
+bool IsRecording();
+bool Dump(const std::string& path);
+
+void SetThreadName(const std::string& name);
+
+void AddActivation(const char* actor_type, const std::string& actor_id,
+                   const int64_t message_count, const int64_t begin_usec,
+                   const int64_t end_usec);
+void AddTimerBatch(const int64_t event_count, const int64_t begin_usec,
+                   const int64_t end_usec);
+void AddSocketIo(const char* name, const std::string& session_id,
+                 const size_t bytes, const int64_t begin_usec,
+                 const int64_t end_usec);
+
+}  // namespace TraceRecorder
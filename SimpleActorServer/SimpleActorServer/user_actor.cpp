@@ -2,8 +2,9 @@
 
 #include <memory>
 
-#include "json.h"
+#include "chat_batch.h"
 #include "logger.h"
+#include "messages.h"
 #include "network_utility.h"
 #include "room_manager.h"
 #include "session.h"
@@ -17,6 +18,16 @@ void OnOpenedSession(const std::shared_ptr<Session>& session,
   UserManager::CreateUser(session->GetSessionId());
 }
 
+//: the matchmaking seat is given back along with the exit event
+void ExitRoom(const std::shared_ptr<UserActor>& user_actor,
+              const std::shared_ptr<RoomActor>& room_actor) {
+  auto data = std::make_shared<RoomActor::LocalEventData>();
+  data->InitExitRoom(user_actor->GetSessionId());
+  room_actor->SendAsyncEvent(
+      static_cast<int>(RoomActor::LocalEventType::EXIT_ROOM), data);
+  RoomManager::LeaveRoom(room_actor->GetRoomId());
+}
+
 void OnClosedSession(const std::shared_ptr<Session>& session,
                      const std::shared_ptr<ActorBaseModel>& actor) {
   auto user_actor = std::dynamic_pointer_cast<UserActor>(actor);
@@ -28,14 +39,34 @@ void OnClosedSession(const std::shared_ptr<Session>& session,
     return;
   }
 
-  auto data = std::make_shared<RoomActor::LocalEventData>();
-  data->InitExitRoom(user_actor->GetSessionId());
-  room_actor->SendAsyncEvent(
-      static_cast<int>(RoomActor::LocalEventType::EXIT_ROOM), data);
+  ExitRoom(user_actor, room_actor);
+}
+
+void OnHello(const std::shared_ptr<Session>& session,
+             const MessageBody& body) {
+  Protocol::Hello request;
+  Protocol::HelloAck ack;
+  ack.result = static_cast<int>(ResultType::Sucess);
+  ack.codec = static_cast<int>(session->GetCodec());
+  if (not body.Decode(&request)) {
+    ack.result = static_cast<int>(ResultType::Error);
+    session->SendMessage(SimpleMessage::MakeMessage(ack, session->GetCodec()));
+    return;
+  }
+
+  // an unknown codec falls back to JSON, the ack tells which one is used
+  const Codec codec = (request.codec == static_cast<int>(Codec::BINARY))
+                          ? Codec::BINARY
+                          : Codec::JSON;
+  ack.codec = static_cast<int>(codec);
+
+  // the ack still goes out in the codec the peer reads until it sees it
+  session->SendMessage(SimpleMessage::MakeMessage(ack, session->GetCodec()));
+  session->SetCodec(codec);
 }
 
 void OnRegisterUser(const std::shared_ptr<Session>& session,
-                    const Json& request) {
+                    const MessageBody& body) {
   auto user_actor = UserManager::GetUser(session->GetSessionId());
   if (not user_actor) {
     Session::SendErrorMessage(session, MessageType::RegisterAck,
@@ -43,24 +74,30 @@ void OnRegisterUser(const std::shared_ptr<Session>& session,
     return;
   }
 
-  std::string nickname;
-  if (not request.GetAttribute("nickname", &nickname)) {
+  Protocol::Register request;
+  if (not body.Decode(&request)) {
     Session::SendErrorMessage(session, MessageType::RegisterAck,
                               ResultType::Error);
     return;
   }
 
-  user_actor->SetNickname(nickname);
+  user_actor->SetNickname(request.nickname);
 
-  Json res_doc;
-  res_doc.SetObject();
-  res_doc.SetAttribute("result", static_cast<int>(ResultType::Sucess));
-  auto response = SimpleMessage::MakeMessage(
-      static_cast<int>(MessageType::RegisterAck), res_doc);
-  session->SendMessage(response);
+  // rooms keep the nickname to leave a member's own chats out
+  auto room_actor = user_actor->GetRoomActor();
+  if (room_actor) {
+    auto data = std::make_shared<RoomActor::LocalEventData>();
+    data->InitRenameMember(user_actor->GetSessionId(), request.nickname);
+    room_actor->SendAsyncEvent(
+        static_cast<int>(RoomActor::LocalEventType::RENAME_MEMBER), data);
+  }
+
+  Session::SendResultMessage(session, MessageType::RegisterAck,
+                             ResultType::Sucess);
 }
 
-void OnEnterRoom(const std::shared_ptr<Session>& session, const Json& request) {
+void OnEnterRoom(const std::shared_ptr<Session>& session,
+                 const MessageBody& body) {
   auto user_actor = UserManager::GetUser(session->GetSessionId());
   if (not user_actor) {
     Session::SendErrorMessage(session, MessageType::EnterRoomAck,
@@ -68,7 +105,15 @@ void OnEnterRoom(const std::shared_ptr<Session>& session, const Json& request) {
     return;
   }
 
-  auto room_actor = RoomManager::GetRandomRoom();
+  // only the current room is left on close, so an earlier one is left
+  // here, before matching, since its seat may be the free one
+  auto previous_room = user_actor->GetRoomActor();
+  if (previous_room) {
+    ExitRoom(user_actor, previous_room);
+    user_actor->ClearRoomActor();
+  }
+
+  auto room_actor = RoomManager::MatchRoom();
   if (not room_actor) {
     Session::SendErrorMessage(session, MessageType::EnterRoomAck,
                               ResultType::Error);
@@ -76,21 +121,19 @@ void OnEnterRoom(const std::shared_ptr<Session>& session, const Json& request) {
   }
 
   auto data = std::make_shared<RoomActor::LocalEventData>();
-  data->InitEnterRoom(user_actor);
+  data->InitEnterRoom(session->GetSessionId(), user_actor->GetNickname(),
+                      session);
   room_actor->SendAsyncEvent(
       static_cast<int>(RoomActor::LocalEventType::ENTER_ROOM), data);
 
   user_actor->SetRoomActor(room_actor);
 
-  Json res_doc;
-  res_doc.SetObject();
-  res_doc.SetAttribute("result", static_cast<int>(ResultType::Sucess));
-  auto response = SimpleMessage::MakeMessage(
-      static_cast<int>(MessageType::EnterRoomAck), res_doc);
-  session->SendMessage(response);
+  Session::SendResultMessage(session, MessageType::EnterRoomAck,
+                             ResultType::Sucess);
 }
 
-void OnExitRoom(const std::shared_ptr<Session>& session, const Json& request) {
+void OnExitRoom(const std::shared_ptr<Session>& session,
+                const MessageBody& body) {
   auto user_actor = UserManager::GetUser(session->GetSessionId());
   if (not user_actor) {
     Session::SendErrorMessage(session, MessageType::ExitRoomAck,
@@ -105,23 +148,15 @@ void OnExitRoom(const std::shared_ptr<Session>& session, const Json& request) {
     return;
   }
 
-  auto data = std::make_shared<RoomActor::LocalEventData>();
-  data->InitExitRoom(user_actor->GetSessionId());
-  room_actor->SendAsyncEvent(
-      static_cast<int>(RoomActor::LocalEventType::EXIT_ROOM), data);
-
+  ExitRoom(user_actor, room_actor);
   user_actor->ClearRoomActor();
 
-  Json res_doc;
-  res_doc.SetObject();
-  res_doc.SetAttribute("result", static_cast<int>(ResultType::Sucess));
-  auto response = SimpleMessage::MakeMessage(
-      static_cast<int>(MessageType::ExitRoomAck), res_doc);
-  session->SendMessage(response);
+  Session::SendResultMessage(session, MessageType::ExitRoomAck,
+                             ResultType::Sucess);
 }
 
 void OnSendChatMessage(const std::shared_ptr<Session>& session,
-                       const Json& request) {
+                       const MessageBody& body) {
   auto user_actor = UserManager::GetUser(session->GetSessionId());
   if (not user_actor) {
     Session::SendErrorMessage(session, MessageType::SendChatAck,
@@ -129,8 +164,10 @@ void OnSendChatMessage(const std::shared_ptr<Session>& session,
     return;
   }
 
-  std::string chat_message;
-  if (not request.GetAttribute("chat_message", &chat_message)) {
+  Protocol::SendChat request;
+  if (not body.Decode(&request) or
+      not ChatBatch::FitsFrame(user_actor->GetNickname(),
+                               request.chat_message)) {
     Session::SendErrorMessage(session, MessageType::SendChatAck,
                               ResultType::Error);
     return;
@@ -144,16 +181,13 @@ void OnSendChatMessage(const std::shared_ptr<Session>& session,
   }
 
   auto data = std::make_shared<RoomActor::LocalEventData>();
-  data->InitBroadcating(user_actor->GetNickname(), chat_message);
+  data->InitBroadcating(user_actor->GetNickname(), request.chat_message);
   room_actor->SendAsyncEvent(
       static_cast<int>(RoomActor::LocalEventType::BROADCASTING), data);
+  room_actor->PauseRead(session);
 
-  Json res_doc;
-  res_doc.SetObject();
-  res_doc.SetAttribute("result", static_cast<int>(ResultType::Sucess));
-  auto response = SimpleMessage::MakeMessage(
-      static_cast<int>(MessageType::SendChatAck), res_doc);
-  session->SendMessage(response);
+  Session::SendResultMessage(session, MessageType::SendChatAck,
+                             ResultType::Sucess);
 }
 
 }  // namespace
@@ -162,6 +196,8 @@ void UserActor::InitializeHandler() {
   MessageHandler::RegisterSessionOpened(OnOpenedSession);
   MessageHandler::RegisterSessionClosed(OnClosedSession);
 
+  MessageHandler::RegisterHandler(static_cast<int>(MessageType::Hello),
+                                  OnHello);
   MessageHandler::RegisterHandler(static_cast<int>(MessageType::Register),
                                   OnRegisterUser);
   MessageHandler::RegisterHandler(static_cast<int>(MessageType::EnterRoom),
@@ -173,7 +209,9 @@ void UserActor::InitializeHandler() {
 }
 
 UserActor::UserActor(const std::string& session_id)
-    : session_id_(session_id), nickname_("") {}
+    : ActorBaseModel(std::hash<std::string>()(session_id)),
+      session_id_(session_id),
+      nickname_("") {}
 
 UserActor::~UserActor() {}
 
@@ -181,48 +219,3 @@ void UserActor::SelfEvent(const int64_t expected_msec) {
   ActorBaseModel::SelfEvent(expected_msec);
   // TODO
 }
-
-void UserActor::SendAsyncEvent(const int type,
-                               const std::shared_ptr<IEventData>& data) {
-  auto local_data = std::dynamic_pointer_cast<LocalEventData>(data);
-  if (not local_data) {
-    Log::Print(Log::Level::ERROR_, "UserActor::SendAsyncEvent(): invalid data");
-    return;
-  }
-
-  auto self(shared_from_this());
-  switch (static_cast<LocalEventType>(type)) {
-    case LocalEventType::SEND_CHAT_MESSAGE:
-      this->AsyncTask([this, self, data = std::move(local_data)] {
-        _SendChatMessage(data->sender, data->chat_message);
-      });
-      break;
-
-    default:
-      Log::Print(Log::Level::ERROR_, "UserActor::SendAsyncEvent(" +
-                                         std::to_string(type) +
-                                         "): invalid type");
-      break;
-  }
-}
-
-void UserActor::_SendChatMessage(const std::string& sender,
-                                 const std::string& chat_message) {
-  if (sender == nickname_) {
-    return;
-  }
-
-  auto session = Connection::GetSession(session_id_);
-  if (not session) {
-    return;
-  }
-
-  Json res_doc;
-  res_doc.SetObject();
-  res_doc.SetAttribute("result", static_cast<int>(ResultType::Sucess));
-  res_doc.SetAttribute("sender", sender);
-  res_doc.SetAttribute("chat_message", chat_message);
-  auto response = SimpleMessage::MakeMessage(
-      static_cast<int>(MessageType::BroadcastingChat), res_doc);
-  session->SendMessage(response);
-}
\ No newline at end of file
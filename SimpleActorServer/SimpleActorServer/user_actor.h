@@ -4,22 +4,11 @@
 
 class RoomActor;
 
+//:
+//: takes no events, rooms write chats to the member sessions themselves
+//:
 class UserActor : public ActorBaseModel {
  public:
-  enum class LocalEventType {
-    NONE = 0,
-    SEND_CHAT_MESSAGE,
-  };
-  struct LocalEventData : IEventData {
-    void InitChatMessage(const std::string& _sender,
-                         const std::string& _chat_message) {
-      sender = _sender;
-      chat_message = _chat_message;
-    }
-    std::string sender;
-    std::string chat_message;
-  };
-
   UserActor(const std::string& session_id);
   virtual ~UserActor();
 
@@ -36,9 +25,10 @@ class UserActor : public ActorBaseModel {
   inline void ClearRoomActor() { room_actor_.reset(); }
 #pragma endregion
 
+  virtual const char* GetActorType() const { return "UserActor"; }
+  virtual std::string GetActorId() const { return session_id_; }
+
   virtual void SelfEvent(const int64_t expected_msec);
-  virtual void SendAsyncEvent(const int type,
-                              const std::shared_ptr<IEventData>&);
 
   static void InitializeHandler();
 
@@ -46,7 +36,4 @@ class UserActor : public ActorBaseModel {
   const std::string session_id_;
   std::string nickname_;
   std::weak_ptr<RoomActor> room_actor_;
-
-  void _SendChatMessage(const std::string& sender,
-                        const std::string& chat_message);
 };
\ No newline at end of file
@@ -35,3 +35,16 @@ void UserManager::EraseUser(const std::string& session_id) {
   boost::lock_guard<boost::detail::spinlock> lock{user_lock};
   users.erase(session_id);
 }
+
+size_t UserManager::GetUserCount() {
+  boost::lock_guard<boost::detail::spinlock> lock{user_lock};
+  return users.size();
+}
+
+void UserManager::ForEachUser(
+    const std::function<void(const std::shared_ptr<UserActor>&)>& visit) {
+  boost::lock_guard<boost::detail::spinlock> lock{user_lock};
+  for (const auto& entry : users) {
+    visit(entry.second);
+  }
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -13,5 +14,8 @@ namespace UserManager {
 void CreateUser(const std::string& session_id);
 std::shared_ptr<UserActor> GetUser(const std::string& session_id);
 void EraseUser(const std::string& session_id);
+size_t GetUserCount();
+void ForEachUser(
+    const std::function<void(const std::shared_ptr<UserActor>&)>& visit);
 
 }  // namespace UserManager
\ No newline at end of file
@@ -1,33 +1,43 @@
 #include "utility.h"
 
-#include <boost/date_time.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#include <functional>
+#include <random>
+#include <thread>
 
-std::string Utility::GenerateStringUuid() {
-  boost::uuids::uuid uuid = boost::uuids::random_generator()();
-  return boost::lexical_cast<std::string>(uuid);
+namespace {
+
+uint64_t SeedRandom() {
+  std::random_device device;
+  uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^ device() ^
+                  std::hash<std::thread::id>()(std::this_thread::get_id());
+  // xorshift never leaves zero
+  return seed == 0 ? 0x9e3779b97f4a7c15ULL : seed;
 }
 
-int Utility::RandomGenerateNumber(const int start, const int end) {
-  srand((unsigned)time(NULL));
-  return rand() % end + start;
+//: xorshift64*, seeded once per thread
+uint64_t NextRandom() {
+  thread_local uint64_t state = SeedRandom();
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545f4914f6cdd1dULL;
 }
 
-int64_t Utility::GetMillisTimestampFromNow() {
-  boost::posix_time::ptime time_t_epoch(boost::gregorian::date(1970, 1, 1));
-  boost::posix_time::ptime now =
-      boost::posix_time::microsec_clock::local_time();
-  boost::posix_time::time_duration diff = now - time_t_epoch;
-  return diff.total_milliseconds();
+}  // namespace
+
+std::string Utility::GenerateStringUuid() {
+  boost::uuids::uuid uuid = boost::uuids::random_generator()();
+  return boost::lexical_cast<std::string>(uuid);
 }
 
-int64_t Utility::GetTimestampFromNow() {
-  boost::posix_time::ptime time_t_epoch(boost::gregorian::date(1970, 1, 1));
-  boost::posix_time::ptime now =
-      boost::posix_time::microsec_clock::local_time();
-  boost::posix_time::time_duration diff = now - time_t_epoch;
-  return diff.total_seconds();
+int Utility::RandomGenerateNumber(const int start, const int end) {
+  if (end <= start) {
+    return start;
+  }
+  const uint64_t range = static_cast<uint64_t>(end) - start;
+  return static_cast<int>(start + NextRandom() % range);
 }
\ No newline at end of file
@@ -1,24 +1,49 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+// gcc and clang have these as keywords, msvc only under /permissive-
+#ifdef _MSC_VER
 #define not !
 #define and &&
 #define or ||
+#endif
 
 const int THREAD_POOL_THREAD_COUNT = 16;
+const bool THREAD_POOL_AFFINITY = false;  // actors run on a home worker
+const size_t THREAD_POOL_AFFINITY_OVERLOAD = 64;  // home queue depth
+const int MAILBOX_CONTROL_BURST = 16;  // control tasks before a bulk one
+const int MAILBOX_HIGH_WATERMARK = 1024;  // feeding sessions stop reading
+const int MAILBOX_LOW_WATERMARK = 256;    // and read again
 const int TIMER_EVENT_THREAD_COUNT = 4;
+const int64_t TIMER_EVENT_IDLE_MSEC = 100;  // longest sleep of a timer worker
 const int ASIO_THREAD_COUNT = 2;
 const short LISTEN_PORT = 5959;
+const short METRICS_PORT = 5960;
+const unsigned int TRACE_SAMPLE_RATE = 1024;  // 1-in-N, 0 disables
+const size_t TRACE_RECORDER_CAPACITY = 262144;
+const int64_t WATCHDOG_INTERVAL_MSEC = 1000;
+const int64_t WATCHDOG_LONG_TASK_MSEC = 500;
+const int WATCHDOG_BACKLOG_THRESHOLD = 1000;
+const int WATCHDOG_GROWTH_SAMPLES = 3;  // consecutive growing samples
+const int64_t WATCHDOG_REPORT_INTERVAL_MSEC = 10000;  // per actor / worker
+const int WATCHDOG_MAX_REPORTS_PER_SAMPLE = 10;
+const size_t SESSION_CAPTURE_FLUSH_BYTES = 65536;
+const size_t SESSION_OUTBOUND_LIMIT_BYTES = 262144;  // queued per session
+const int64_t SESSION_OUTBOUND_GRACE_MSEC = 5000;  // OutboundPolicy::DISCONNECT
+const int64_t ROOM_CHAT_BATCH_MSEC = 0;  // chat batching window, 0 disables
+const size_t ROOM_SHARD_THRESHOLD = 1024;  // members before fan-out shards
+const size_t ROOM_SHARD_COUNT = 8;
+const size_t ROOM_CAPACITY = 20000;  // seats MatchRoom hands out per room
+const int64_t CLOCK_TICK_MSEC = 10;  // wall clock cache for logs
 
 namespace Utility {
 
 std::string GenerateStringUuid();
 
+//: start <= n < end from a per-thread generator, start if the range is empty
 int RandomGenerateNumber(const int start, const int end);
 
-int64_t GetMillisTimestampFromNow();
-
-int64_t GetTimestampFromNow();
-
 }  // namespace Utility
\ No newline at end of file
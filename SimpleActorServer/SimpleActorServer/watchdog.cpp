@@ -0,0 +1,173 @@
+#include "watchdog.h"
+
+#include <vector>
+
+#include "actor_base_model.h"
+#include "clock.h"
+#include "logger.h"
+#include "metrics.h"
+#include "room_actor.h"
+#include "room_manager.h"
+#include "room_shard_actor.h"
+#include "thread_pool_manager.h"
+#include "user_manager.h"
+#include "utility.h"
+
+namespace {
+
+std::string GetActorName(const std::shared_ptr<ActorBaseModel>& actor) {
+  return std::string(actor->GetActorType()) + ":" + actor->GetActorId();
+}
+
+}  // namespace
+
+Watchdog::Watchdog() : sample_reports_(0), suppressed_reports_(0) {
+  thread_ = std::make_unique<boost::thread>([this]() { this->RunThread(); });
+}
+
+Watchdog::~Watchdog() {
+  if (!!thread_ and thread_->joinable()) {
+    thread_->interrupt();
+    thread_->join();
+  }
+  thread_.reset();
+}
+
+void Watchdog::RunThread() {
+  try {
+    while (true) {
+      boost::this_thread::interruption_point();
+      Sample();
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(WATCHDOG_INTERVAL_MSEC));
+    }
+  } catch (...) {
+    Log::Print(Log::Level::INFO, "Watchdog Interrupted Thread");
+  }
+}
+
+void Watchdog::Sample() {
+  const int64_t now_msec = Clock::GetMillis();
+  sample_reports_ = 0;
+  suppressed_reports_ = 0;
+
+  CheckWorkers(now_msec);
+
+  // copy out under the manager locks, inspect without holding them
+  // sized up front so the copy doesn't reallocate inside the locks, the
+  // shards are added after them
+  std::vector<std::shared_ptr<ActorBaseModel>> actors;
+  actors.reserve(UserManager::GetUserCount() + RoomManager::GetRoomCount());
+  UserManager::ForEachUser([&actors](const std::shared_ptr<UserActor>& user) {
+    actors.emplace_back(user);
+  });
+  const size_t room_begin = actors.size();
+  RoomManager::ForEachRoom([&actors](const std::shared_ptr<RoomActor>& room) {
+    actors.emplace_back(room);
+  });
+  // a large room's chats queue up in its shards rather than in the room
+  const size_t room_end = actors.size();
+  for (size_t i = room_begin; i < room_end; ++i) {
+    const auto room = std::static_pointer_cast<RoomActor>(actors[i]);
+    for (auto& shard : room->GetShards()) {
+      actors.emplace_back(std::move(shard));
+    }
+  }
+  for (const auto& actor : actors) {
+    CheckMailbox(actor, now_msec);
+  }
+
+  // forget actors that were not seen in this sample
+  for (auto it = backlogs_.begin(); it != backlogs_.end();) {
+    if (it->second.sampled_msec != now_msec) {
+      it = backlogs_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = reported_msec_.begin(); it != reported_msec_.end();) {
+    if (now_msec - it->second >= WATCHDOG_REPORT_INTERVAL_MSEC) {
+      it = reported_msec_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (suppressed_reports_ == 0) {
+    return;
+  }
+  Metrics::AddWatchdogSuppressed(suppressed_reports_);
+  if (sample_reports_ >= WATCHDOG_MAX_REPORTS_PER_SAMPLE) {
+    Log::Print(Log::Level::WARNING,
+               "Watchdog: suppressed " + std::to_string(suppressed_reports_) +
+                   " reports");
+  }
+}
+
+void Watchdog::CheckWorkers(const int64_t now_msec) {
+  const auto workers = ThreadPoolManager::GetInstance()->GetWorkerStatus();
+  for (const auto& worker : workers) {
+    if (worker.task_begin_msec == 0) {
+      continue;
+    }
+    const int64_t elapsed_msec = now_msec - worker.task_begin_msec;
+    if (elapsed_msec < WATCHDOG_LONG_TASK_MSEC) {
+      continue;
+    }
+
+    std::string v = "Watchdog: worker " + std::to_string(worker.worker_index) +
+                    " running one task for " + std::to_string(elapsed_msec) +
+                    "ms";
+    if (!!worker.actor) {
+      v += " in " + GetActorName(worker.actor) + " (mailbox " +
+           std::to_string(worker.actor->GetMailboxDepth()) + ")";
+    }
+    Report("worker:" + std::to_string(worker.worker_index), true, v,
+           now_msec);
+  }
+}
+
+void Watchdog::CheckMailbox(const std::shared_ptr<ActorBaseModel>& actor,
+                            const int64_t now_msec) {
+  // a tracked actor that drained is dropped by the sweep in Sample(), so
+  // the name is only built for actors over the threshold
+  const int depth = actor->GetMailboxDepth();
+  if (depth < WATCHDOG_BACKLOG_THRESHOLD) {
+    return;
+  }
+  const std::string name = GetActorName(actor);
+
+  auto it = backlogs_.find(name);
+  if (it == backlogs_.end()) {
+    it = backlogs_.emplace(name, BacklogState{depth, 0, now_msec}).first;
+  }
+
+  auto& state = it->second;
+  state.growth_count = (depth > state.last_depth) ? state.growth_count + 1 : 0;
+  state.last_depth = depth;
+  state.sampled_msec = now_msec;
+
+  if (state.growth_count < WATCHDOG_GROWTH_SAMPLES) {
+    return;
+  }
+
+  Report(name, false,
+         "Watchdog: " + name + " mailbox " + std::to_string(depth) +
+             " and growing for " + std::to_string(state.growth_count) +
+             " samples",
+         now_msec);
+}
+
+void Watchdog::Report(const std::string& subject, const bool is_long_task,
+                      const std::string& v, const int64_t now_msec) {
+  if (reported_msec_.count(subject) != 0 or
+      sample_reports_ >= WATCHDOG_MAX_REPORTS_PER_SAMPLE) {
+    ++suppressed_reports_;
+    return;
+  }
+  reported_msec_.emplace(subject, now_msec);
+  ++sample_reports_;
+
+  Metrics::AddWatchdogReport(is_long_task);
+  Log::Print(Log::Level::WARNING, v);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <boost/thread.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class ActorBaseModel;
+
+//:
+//: samples thread pool workers and actor mailboxes
+//: reports tasks running longer than WATCHDOG_LONG_TASK_MSEC and mailboxes
+//: that stay above WATCHDOG_BACKLOG_THRESHOLD while still growing
+//:
+class Watchdog {
+ public:
+  Watchdog();
+  ~Watchdog();
+
+ private:
+  struct BacklogState {
+    int last_depth;
+    int growth_count;
+    int64_t sampled_msec;
+  };
+
+  std::unique_ptr<boost::thread> thread_;
+  std::unordered_map<std::string, BacklogState> backlogs_;
+  std::unordered_map<std::string, int64_t> reported_msec_;
+  int sample_reports_;
+  uint64_t suppressed_reports_;
+
+  void RunThread();
+  void Sample();
+  void CheckWorkers(const int64_t now_msec);
+  void CheckMailbox(const std::shared_ptr<ActorBaseModel>& actor,
+                    const int64_t now_msec);
+  void Report(const std::string& subject, const bool is_long_task,
+              const std::string& v, const int64_t now_msec);
+};
@@ -0,0 +1,110 @@
+#include <boost/asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "logger.h"
+#include "room_actor.h"
+#include "room_shard_actor.h"
+#include "session.h"
+#include "thread_pool_manager.h"
+#include "utility.h"
+
+namespace {
+
+const int WAIT_TIMEOUT_MSEC = 5000;
+
+int failure_count = 0;
+
+#define CHECK(condition)                                              \
+  do {                                                                \
+    if (!(condition)) {                                               \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition \
+                << ") failed\n";                                      \
+      ++failure_count;                                                \
+    }                                                                 \
+  } while (false)
+
+//: false if condition didn't hold within WAIT_TIMEOUT_MSEC
+bool WaitUntil(const std::function<bool()>& condition) {
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(WAIT_TIMEOUT_MSEC);
+  while (not condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+//:
+//: a sharded room forwards chats as fast as they come, a reader has to
+//: stop on a full shard mailbox even though the room's stays short
+//:
+void TestShardBackpressure() {
+  boost::asio::io_context io_context;
+  auto session =
+      std::make_shared<Session>(boost::asio::ip::tcp::socket(io_context));
+  auto room = std::make_shared<RoomActor>();
+  for (size_t i = 0; i < ROOM_SHARD_THRESHOLD; ++i) {
+    // members without a session, nothing is broadcast to them
+    const std::string id = "member-" + std::to_string(i);
+    auto data = std::make_shared<RoomActor::LocalEventData>();
+    data->InitEnterRoom(id, id, std::shared_ptr<Session>());
+    room->SendAsyncEvent(
+        static_cast<int>(RoomActor::LocalEventType::ENTER_ROOM), data);
+  }
+  CHECK(WaitUntil([&room]() {
+    return not room->GetShards().empty() and room->GetMailboxDepth() == 0;
+  }));
+  const auto shards = room->GetShards();
+  if (shards.empty()) {
+    return;
+  }
+
+  room->PauseRead(session);
+  CHECK(not session->IsReadPaused());
+
+  // the first task holds the shard's worker until the rest are queued
+  const auto& shard = shards.front();
+  std::atomic<bool> is_released{false};
+  shard->AsyncTask([&is_released]() {
+    while (not is_released.load()) {
+      std::this_thread::yield();
+    }
+  });
+  for (int i = 0; i < MAILBOX_HIGH_WATERMARK; ++i) {
+    shard->AsyncTask([]() {});
+  }
+  CHECK(shard->IsOverloaded());
+  CHECK(not room->IsOverloaded());
+
+  room->PauseRead(session);
+  CHECK(session->IsReadPaused());
+
+  // the holding task reads is_released until the shard gets to run it
+  is_released.store(true);
+  CHECK(WaitUntil([&shard]() { return shard->GetMailboxDepth() == 0; }));
+  CHECK(not session->IsReadPaused());
+}
+
+}  // namespace
+
+int main() {
+  Log::SetLogLevel(Log::Level::WARNING);
+
+  TestShardBackpressure();
+
+  ThreadPoolManager::GetInstance()->Stop();
+  if (failure_count > 0) {
+    std::cerr << failure_count << " check(s) failed\n";
+    return 1;
+  }
+  std::cout << "all checks passed\n";
+  return 0;
+}
@@ -0,0 +1,635 @@
+#!/usr/bin/env python3
+"""Generates messages.h for the server and DummyClient from messages.json.
+
+usage: generate_messages.py [--check]
+
+Every message in the schema becomes a struct in namespace Protocol with a
+JSON codec (the msg_body object) and a binary one (a MessagePack array of
+the fields in schema order). Message names must match MessageType in
+simple_message.h.
+
+--check only compares the checked-in headers with what would be generated
+and exits with 1 when they differ.
+"""
+
+import json
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SCHEMA = os.path.join(ROOT, 'protocol', 'messages.json')
+MESSAGE_TYPES = os.path.join(ROOT, 'SimpleActorServer', 'SimpleActorServer',
+                             'simple_message.h')
+OUTPUTS = [
+    os.path.join(ROOT, 'SimpleActorServer', 'SimpleActorServer', 'messages.h'),
+    os.path.join(ROOT, 'DummyClient', 'DummyClient', 'messages.h'),
+]
+
+CPP_TYPES = {'int': 'int', 'string': 'std::string',
+             'string[]': 'std::vector<std::string>'}
+INITIALIZERS = {'int': ' = 0', 'string': '', 'string[]': ''}
+MAX_FIELDS = 15  # fixarray
+
+HEADER = r'''// generated by protocol/generate_messages.py from protocol/messages.json
+// do not edit, change the schema and run the script again
+
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../rapidjson/memorystream.h"
+#include "../rapidjson/reader.h"
+#include "simple_message.h"
+
+namespace Protocol {
+
+namespace Detail {
+
+//:
+//: bounded writer over a caller buffer, Finish() is 0 once anything
+//: didn't fit
+//:
+class Output {
+ public:
+  Output(char* data, const std::size_t capacity)
+      : data_(data), capacity_(capacity), length_(0), overflow_(false) {}
+
+  void Put(const char c) {
+    if (length_ < capacity_) {
+      data_[length_++] = c;
+    } else {
+      overflow_ = true;
+    }
+  }
+  void Put(const char* s, const std::size_t n) {
+    if (capacity_ - length_ >= n) {
+      std::memcpy(data_ + length_, s, n);
+      length_ += n;
+    } else {
+      overflow_ = true;
+    }
+  }
+  std::size_t Finish() const { return overflow_ ? 0 : length_; }
+
+ private:
+  char* data_;
+  const std::size_t capacity_;
+  std::size_t length_;
+  bool overflow_;
+};
+
+class Input {
+ public:
+  Input(const char* data, const std::size_t length)
+      : pos_(reinterpret_cast<const uint8_t*>(data)), end_(pos_ + length) {}
+
+  bool Get(uint8_t* c) {
+    if (pos_ == end_) {
+      return false;
+    }
+    *c = *pos_++;
+    return true;
+  }
+  bool Get(const std::size_t n, uint64_t* v) {
+    if (static_cast<std::size_t>(end_ - pos_) < n) {
+      return false;
+    }
+    *v = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      *v = (*v << 8) | *pos_++;
+    }
+    return true;
+  }
+  bool Get(const std::size_t n, std::string* s) {
+    if (static_cast<std::size_t>(end_ - pos_) < n) {
+      return false;
+    }
+    s->assign(reinterpret_cast<const char*>(pos_), n);
+    pos_ += n;
+    return true;
+  }
+  bool IsEnd() const { return pos_ == end_; }
+  const char* GetPosition() const {
+    return reinterpret_cast<const char*>(pos_);
+  }
+
+ private:
+  const uint8_t* pos_;
+  const uint8_t* const end_;
+};
+
+template <std::size_t N>
+inline bool IsKey(const char* key, const std::size_t length,
+                  const char (&name)[N]) {
+  return length == N - 1 && std::memcmp(key, name, N - 1) == 0;
+}
+
+#pragma region json
+inline void WriteJson(Output* out, const int value) {
+  char digits[12];
+  std::size_t n = 0;
+  unsigned magnitude = (value < 0) ? 0u - static_cast<unsigned>(value)
+                                   : static_cast<unsigned>(value);
+  do {
+    digits[n++] = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) {
+    out->Put('-');
+  }
+  while (n > 0) {
+    out->Put(digits[--n]);
+  }
+}
+
+inline char GetEscape(const unsigned char c) {
+  switch (c) {
+    case '"':
+      return '"';
+    case '\\':
+      return '\\';
+    case '\b':
+      return 'b';
+    case '\f':
+      return 'f';
+    case '\n':
+      return 'n';
+    case '\r':
+      return 'r';
+    case '\t':
+      return 't';
+    default:
+      return (c < 0x20) ? 'u' : 0;
+  }
+}
+
+//: escapes like rapidjson::Writer, so both encoders give the same bytes
+inline void WriteJson(Output* out, const std::string& value) {
+  static const char HEX[] = "0123456789ABCDEF";
+  out->Put('"');
+  const char* begin = value.data();
+  const char* const end = begin + value.size();
+  for (const char* p = begin; p != end; ++p) {
+    const unsigned char c = static_cast<unsigned char>(*p);
+    const char escape = GetEscape(c);
+    if (escape == 0) {
+      continue;
+    }
+    out->Put(begin, p - begin);
+    begin = p + 1;
+    out->Put('\\');
+    out->Put(escape);
+    if (escape == 'u') {
+      const char code[4] = {'0', '0', HEX[c >> 4], HEX[c & 0xf]};
+      out->Put(code, sizeof(code));
+    }
+  }
+  out->Put(begin, end - begin);
+  out->Put('"');
+}
+
+inline void WriteJson(Output* out, const std::vector<std::string>& values) {
+  out->Put('[');
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    if (i != 0) {
+      out->Put(',');
+    }
+    WriteJson(out, values[i]);
+  }
+  out->Put(']');
+}
+
+//:
+//: SAX handler filling T from the members of the root object
+//: the key is resolved to a field index as soon as it's read, since the
+//: reader reuses the key's memory for the value
+//: a list field is an array of strings directly under its key
+//:
+template <typename T>
+class JsonHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JsonHandler<T>> {
+ public:
+  explicit JsonHandler(T* msg)
+      : msg_(msg),
+        depth_(0),
+        field_(-1),
+        is_object_(false),
+        is_list_(false),
+        seen_(0) {}
+
+  bool Default() { return true; }
+  bool Int(int i) {
+    if (depth_ == 1 && msg_->SetField(field_, i)) {
+      seen_ |= 1u << field_;
+    }
+    return true;
+  }
+  bool Uint(unsigned u) {
+    return (u <= static_cast<unsigned>(INT_MAX)) ? Int(static_cast<int>(u))
+                                                 : true;
+  }
+  bool String(const char* str, rapidjson::SizeType length, bool /*copy*/) {
+    if (depth_ == 1 && msg_->SetField(field_, str, length)) {
+      seen_ |= 1u << field_;
+    } else if (depth_ == 2 && is_list_) {
+      msg_->AddField(field_, str, length);
+    }
+    return true;
+  }
+  bool StartObject() {
+    is_object_ = is_object_ || depth_ == 0;
+    ++depth_;
+    return true;
+  }
+  bool Key(const char* str, rapidjson::SizeType length, bool /*copy*/) {
+    if (depth_ == 1) {
+      field_ = T::FindField(str, length);
+    }
+    return true;
+  }
+  bool EndObject(rapidjson::SizeType /*member_count*/) {
+    --depth_;
+    return true;
+  }
+  bool StartArray() {
+    if (depth_ == 1 && msg_->StartList(field_)) {
+      seen_ |= 1u << field_;
+      is_list_ = true;
+    }
+    ++depth_;
+    return true;
+  }
+  bool EndArray(rapidjson::SizeType /*element_count*/) {
+    --depth_;
+    if (depth_ == 1) {
+      is_list_ = false;
+    }
+    return true;
+  }
+
+  //: every field has to be there
+  bool IsComplete() const {
+    return is_object_ && seen_ == (1u << T::FIELD_COUNT) - 1;
+  }
+
+ private:
+  T* msg_;
+  int depth_;
+  int field_;
+  bool is_object_;
+  bool is_list_;
+  uint32_t seen_;
+};
+
+template <typename T>
+inline bool DecodeJson(const char* data, const std::size_t length, T* msg) {
+  // the reader keeps its stack between messages
+  thread_local rapidjson::Reader reader;
+  rapidjson::MemoryStream stream(data, length);
+  JsonHandler<T> handler(msg);
+  return !reader.Parse(stream, handler).IsError() && handler.IsComplete();
+}
+#pragma endregion
+
+#pragma region binary
+//: MessagePack, small values take the short forms
+inline void WriteBinary(Output* out, const int value) {
+  if (value >= 0 && value <= 0x7f) {
+    out->Put(static_cast<char>(value));
+  } else if (value < 0 && value >= -32) {
+    out->Put(static_cast<char>(0xe0 | (value + 32)));
+  } else if (value >= 0 && value <= 0xffff) {
+    const uint8_t marker = (value <= 0xff) ? 0xcc : 0xcd;
+    const std::size_t n = (value <= 0xff) ? 1 : 2;
+    out->Put(static_cast<char>(marker));
+    for (std::size_t i = n; i > 0; --i) {
+      out->Put(static_cast<char>(value >> ((i - 1) * 8)));
+    }
+  } else {
+    const uint32_t bits = static_cast<uint32_t>(value);
+    out->Put(static_cast<char>(value >= 0 ? 0xce : 0xd2));
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out->Put(static_cast<char>(bits >> shift));
+    }
+  }
+}
+
+inline void WriteBinary(Output* out, const std::string& value) {
+  const std::size_t n = value.size();
+  if (n < 32) {
+    out->Put(static_cast<char>(0xa0 | n));
+  } else if (n <= 0xff) {
+    out->Put(static_cast<char>(0xd9));
+    out->Put(static_cast<char>(n));
+  } else if (n <= 0xffff) {
+    out->Put(static_cast<char>(0xda));
+    out->Put(static_cast<char>(n >> 8));
+    out->Put(static_cast<char>(n));
+  } else {
+    out->Put(static_cast<char>(0xdb));
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out->Put(static_cast<char>(n >> shift));
+    }
+  }
+  out->Put(value.data(), n);
+}
+
+inline void WriteBinary(Output* out, const std::vector<std::string>& values) {
+  const std::size_t n = values.size();
+  if (n <= 15) {
+    out->Put(static_cast<char>(0x90 | n));
+  } else if (n <= 0xffff) {
+    out->Put(static_cast<char>(0xdc));
+    out->Put(static_cast<char>(n >> 8));
+    out->Put(static_cast<char>(n));
+  } else {
+    out->Put(static_cast<char>(0xdd));
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out->Put(static_cast<char>(n >> shift));
+    }
+  }
+  for (const auto& value : values) {
+    WriteBinary(out, value);
+  }
+}
+
+inline bool ReadBinary(Input* in, int* value) {
+  uint8_t marker;
+  if (!in->Get(&marker)) {
+    return false;
+  }
+  if (marker <= 0x7f) {
+    *value = marker;
+    return true;
+  }
+  if (marker >= 0xe0) {
+    *value = static_cast<int8_t>(marker);
+    return true;
+  }
+  uint64_t bits;
+  switch (marker) {
+    case 0xcc:
+    case 0xcd:
+    case 0xce: {
+      const std::size_t n = std::size_t(1) << (marker - 0xcc);
+      if (!in->Get(n, &bits) || bits > static_cast<uint64_t>(INT_MAX)) {
+        return false;
+      }
+      *value = static_cast<int>(bits);
+      return true;
+    }
+    case 0xd0:
+    case 0xd1:
+    case 0xd2: {
+      const std::size_t n = std::size_t(1) << (marker - 0xd0);
+      if (!in->Get(n, &bits)) {
+        return false;
+      }
+      // sign extend from n bytes
+      const uint64_t sign = uint64_t(1) << (n * 8 - 1);
+      *value = static_cast<int>(static_cast<int64_t>((bits ^ sign) - sign));
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+inline bool ReadBinary(Input* in, std::string* value) {
+  uint8_t marker;
+  if (!in->Get(&marker)) {
+    return false;
+  }
+  uint64_t n;
+  if ((marker & 0xe0) == 0xa0) {
+    n = marker & 0x1f;
+  } else if (marker >= 0xd9 && marker <= 0xdb) {
+    if (!in->Get(std::size_t(1) << (marker - 0xd9), &n)) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  return in->Get(static_cast<std::size_t>(n), value);
+}
+
+inline bool ReadBinary(Input* in, std::vector<std::string>* values) {
+  uint8_t marker;
+  if (!in->Get(&marker)) {
+    return false;
+  }
+  uint64_t n;
+  if ((marker & 0xf0) == 0x90) {
+    n = marker & 0x0f;
+  } else if (marker == 0xdc || marker == 0xdd) {
+    if (!in->Get(std::size_t(2) << (marker - 0xdc), &n)) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  values->clear();
+  for (uint64_t i = 0; i < n; ++i) {
+    // every string takes a byte at least, a bogus count runs out first
+    values->emplace_back();
+    if (!ReadBinary(in, &values->back())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline bool ReadBinaryArray(Input* in, const int field_count) {
+  uint8_t marker;
+  return in->Get(&marker) && marker == (0x90 | field_count);
+}
+
+template <typename T>
+inline bool DecodeBinary(const char* data, const std::size_t length, T* msg) {
+  Input in(data, length);
+  return ReadBinaryArray(&in, T::FIELD_COUNT) && msg->ReadBinary(&in) &&
+         in.IsEnd();
+}
+#pragma endregion
+
+template <typename T, typename Encoder>
+inline std::size_t Encode(const T& msg, char* data, const std::size_t capacity,
+                          Encoder encoder) {
+  Output out(data, capacity);
+  (msg.*encoder)(&out);
+  return out.Finish();
+}
+
+}  // namespace Detail
+'''
+
+FOOTER = '''
+}  // namespace Protocol
+'''
+
+
+def load_schema():
+    with open(SCHEMA, encoding='utf-8') as f:
+        schema = json.load(f)
+    with open(MESSAGE_TYPES, encoding='utf-8') as f:
+        enum = re.search(r'enum class MessageType \{(.*?)\};', f.read(), re.S)
+    known = set(re.findall(r'^\s*(\w+)', enum.group(1), re.M))
+    for message in schema['messages']:
+        if message['name'] not in known:
+            sys.exit('%s is not in MessageType' % message['name'])
+        if len(message['fields']) > MAX_FIELDS:
+            sys.exit('%s has more than %d fields' % (message['name'],
+                                                     MAX_FIELDS))
+        for field in message['fields']:
+            if field['type'] not in CPP_TYPES:
+                sys.exit('%s.%s: unknown type %s' % (
+                    message['name'], field['name'], field['type']))
+    return schema['messages']
+
+
+def cpp_string(s):
+    return '"' + s.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+
+def set_field(fields, kind, function, params, assign):
+    """json handler setter for the fields of one kind, false for the others"""
+    matching = [(i, f) for i, f in enumerate(fields) if f['type'] == kind]
+    lines = ['  bool %s(%s) {' % (function, params)]
+    if not matching:
+        names = [p.split()[-1] for p in params.split(',')]
+        lines += ['    (void)%s;' % name for name in names]
+        lines.append('    return false;')
+    else:
+        lines.append('    switch (field) {')
+        for index, field in matching:
+            lines.append('      case %d:' % index)
+            lines.append('        %s;' % (assign % field['name']))
+            lines.append('        return true;')
+        lines.append('      default:')
+        lines.append('        return false;')
+        lines.append('    }')
+    lines.append('  }')
+    return lines
+
+
+def generate_struct(message):
+    name = message['name']
+    fields = message['fields']
+    lines = ['', '//:', '//: %s' % message['comment'], '//:',
+             'struct %s {' % name,
+             '  static constexpr MessageType TYPE = MessageType::%s;' % name,
+             '  enum { FIELD_COUNT = %d };' % len(fields)]
+    if fields:
+        lines.append('')
+    for field in fields:
+        lines.append('  %s %s%s;' % (CPP_TYPES[field['type']], field['name'],
+                                     INITIALIZERS[field['type']]))
+
+    lines += [
+        '',
+        '  bool DecodeJson(const char* data, const std::size_t length) {',
+        '    return Detail::DecodeJson(data, length, this);',
+        '  }',
+        '  std::size_t EncodeJson(char* data, const std::size_t capacity) '
+        'const {',
+        '    return Detail::Encode(*this, data, capacity,',
+        '                          &%s::WriteJson);' % name,
+        '  }',
+        '  bool DecodeBinary(const char* data, const std::size_t length) {',
+        '    return Detail::DecodeBinary(data, length, this);',
+        '  }',
+        '  std::size_t EncodeBinary(char* data, const std::size_t capacity) '
+        'const {',
+        '    return Detail::Encode(*this, data, capacity,',
+        '                          &%s::WriteBinary);' % name,
+        '  }',
+        '',
+        '  static int FindField(const char* key, const std::size_t length) {',
+    ]
+    if not fields:
+        lines += ['    (void)key;', '    (void)length;']
+    for index, field in enumerate(fields):
+        lines += ['    if (Detail::IsKey(key, length, %s)) {'
+                  % cpp_string(field['name']),
+                  '      return %d;' % index,
+                  '    }']
+    lines += ['    return -1;', '  }']
+    string_params = ('const int field, const char* value,\n'
+                     '                const std::size_t length')
+    lines += set_field(fields, 'int', 'SetField',
+                       'const int field, const int value', '%s = value')
+    lines += set_field(fields, 'string', 'SetField', string_params,
+                       '%s.assign(value, length)')
+    lines += set_field(fields, 'string[]', 'StartList', 'const int field',
+                       '%s.clear()')
+    lines += set_field(fields, 'string[]', 'AddField', string_params,
+                       '%s.emplace_back(value, length)')
+
+    # keys are written as precomputed literals, "{\"result\":" and so on
+    lines.append('  void WriteJson(Detail::Output* out) const {')
+    if not fields:
+        lines.append('    out->Put("{}", 2);')
+    for index, field in enumerate(fields):
+        literal = ('{' if index == 0 else ',') + '"%s":' % field['name']
+        lines.append('    out->Put(%s, %d);' % (cpp_string(literal),
+                                                len(literal)))
+        lines.append('    Detail::WriteJson(out, %s);' % field['name'])
+    if fields:
+        lines.append("    out->Put('}');")
+    lines.append('  }')
+
+    lines.append('  void WriteBinary(Detail::Output* out) const {')
+    lines.append('    out->Put(static_cast<char>(0x90 | FIELD_COUNT));')
+    for field in fields:
+        lines.append('    Detail::WriteBinary(out, %s);' % field['name'])
+    lines.append('  }')
+
+    lines.append('  bool ReadBinary(Detail::Input* in) {')
+    if not fields:
+        lines += ['    (void)in;', '    return true;']
+    else:
+        reads = ['Detail::ReadBinary(in, &%s)' % f['name'] for f in fields]
+        lines.append('    return ' + ' &&\n           '.join(reads) + ';')
+    lines.append('  }')
+    lines.append('};')
+    return lines
+
+
+def generate():
+    lines = [HEADER.rstrip('\n')]
+    for message in load_schema():
+        lines += generate_struct(message)
+    return '\n'.join(lines) + '\n' + FOOTER
+
+
+def main():
+    check = '--check' in sys.argv[1:]
+    text = generate()
+    stale = []
+    for path in OUTPUTS:
+        current = None
+        if os.path.exists(path):
+            with open(path, encoding='utf-8', newline='') as f:
+                current = f.read()
+        if current == text:
+            continue
+        stale.append(os.path.relpath(path, ROOT))
+        if not check:
+            with open(path, 'w', encoding='utf-8', newline='') as f:
+                f.write(text)
+    if check and stale:
+        print('out of date: ' + ', '.join(stale))
+        return 1
+    for path in stale:
+        print('generated ' + path)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())